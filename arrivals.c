@@ -0,0 +1,140 @@
+#include "arrivals.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NSEC_PER_HOUR (3600 * NSEC_PER_SEC)
+
+// Hourly demand relative to the daily mean (averages to 1), interpolated
+// linearly between the hours
+static const double COMMUTER_PROFILE[24] = {
+    0.22, 0.17, 0.11, 0.11, 0.17, 0.44, 1.00, 1.98, 2.20, 1.55, 1.11, 1.11,
+    1.22, 1.11, 1.11, 1.33, 1.88, 2.20, 1.77, 1.11, 0.77, 0.55, 0.44, 0.33};
+#define COMMUTER_PEAK 2.20
+
+static double profileFactor(DemandProfile profile, SimTime t) {
+  if (profile == PROFILE_FLAT)
+    return 1.0;
+
+  double hour = fmod((double)t / NSEC_PER_HOUR, 24.0);
+  int h = (int)hour;
+  double f = hour - h;
+  return COMMUTER_PROFILE[h] * (1 - f) + COMMUTER_PROFILE[(h + 1) % 24] * f;
+}
+
+static double profilePeak(DemandProfile profile) {
+  return profile == PROFILE_FLAT ? 1.0 : COMMUTER_PEAK;
+}
+
+// Next event after t of a Poisson process with 'ratePerHour' scaled by the
+// profile. Time-varying rates use thinning: candidates come at the peak rate
+// and are kept with probability rate(t) / peak
+static SimTime nextPoisson(ArrivalStream *s, SimTime t, double ratePerHour) {
+  double peak = ratePerHour * profilePeak(s->spec.profile) / NSEC_PER_HOUR;
+  if (peak <= 0)
+    return INT64_MAX;
+
+  for (;;) {
+    t += (SimTime)(-log1p(-rngUniform(&s->rng)) / peak);
+    if (s->spec.profile == PROFILE_FLAT ||
+        rngUniform(&s->rng) * profilePeak(s->spec.profile) <=
+            profileFactor(s->spec.profile, t))
+      return t;
+  }
+}
+
+// Geometric platoon size with the configured mean, at least 1
+static int platoonSize(ArrivalStream *s) {
+  double mean = s->spec.platoonSize;
+  if (mean <= 1)
+    return 1;
+  double p = 1.0 / mean;
+  return 1 + (int)(log1p(-rngUniform(&s->rng)) / log1p(-p));
+}
+
+// Arrival following one at time t
+static SimTime advance(ArrivalStream *s, SimTime t) {
+  const ArrivalSpec *spec = &s->spec;
+
+  switch (spec->model) {
+  case ARRIVAL_POISSON:
+    return nextPoisson(s, t, spec->ratePerHour);
+
+  case ARRIVAL_PLATOON:
+    // Platoon starts are a Poisson process of their own. A platoon starting
+    // while the previous one is still passing joins its tail
+    if (s->platoonLeft > 0) {
+      while (s->nextPlatoon <= t + spec->headway) {
+        s->platoonLeft += platoonSize(s);
+        s->nextPlatoon = nextPoisson(s, s->nextPlatoon,
+                                     spec->ratePerHour / spec->platoonSize);
+      }
+      s->platoonLeft--;
+      return t + spec->headway;
+    }
+    t = s->nextPlatoon;
+    s->platoonLeft = platoonSize(s) - 1;
+    s->nextPlatoon =
+        nextPoisson(s, t, spec->ratePerHour / spec->platoonSize);
+    return t;
+
+  case ARRIVAL_INTERVAL:
+  default: {
+    int interval = spec->minInterval;
+    if (spec->maxInterval > spec->minInterval)
+      interval += rngBelow(&s->rng, spec->maxInterval - spec->minInterval + 1);
+    return t + interval * NSEC_PER_SEC;
+  }
+  }
+}
+
+void initArrivalStream(ArrivalStream *s, const ArrivalSpec *spec, Rng *parent,
+                       SimTime start) {
+  memset(s, 0, sizeof(*s));
+  s->spec = *spec;
+  if (s->spec.platoonSize < 1)
+    s->spec.platoonSize = 1;
+  rngSplit(parent, &s->rng);
+
+  if (spec->model == ARRIVAL_PLATOON)
+    s->nextPlatoon = nextPoisson(s, start, s->spec.ratePerHour /
+                                               s->spec.platoonSize);
+
+  // Stagger start times like the generator does
+  if (spec->model == ARRIVAL_INTERVAL)
+    s->next = start + rngBelow(&s->rng, 3) * NSEC_PER_SEC;
+  else
+    s->next = advance(s, start);
+}
+
+SimTime nextArrival(ArrivalStream *s) {
+  SimTime t = s->next;
+  if (t != INT64_MAX)
+    s->next = advance(s, t);
+  return t;
+}
+
+size_t generateArrivals(ArrivalStream *s, SimTime until, SimTime *times,
+                        size_t max) {
+  size_t n = 0;
+  while (n < max && s->next < until)
+    times[n++] = nextArrival(s);
+  return n;
+}
+
+double meanArrivalRate(const ArrivalSpec *spec) {
+  if (spec->model != ARRIVAL_INTERVAL)
+    return spec->ratePerHour;
+  return 3600.0 * 2 / (spec->minInterval + spec->maxInterval);
+}
+
+int parseDemandProfile(const char *name, DemandProfile *out) {
+  if (strcmp(name, "flat") == 0)
+    *out = PROFILE_FLAT;
+  else if (strcmp(name, "commuter") == 0)
+    *out = PROFILE_COMMUTER;
+  else
+    return -1;
+  return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef ARRIVALS_H
+#define ARRIVALS_H
+
+#include <stddef.h>
+
+#include "rng.h"
+#include "sim_time.h"
+
+typedef enum {
+  ARRIVAL_INTERVAL, // every minInterval..maxInterval whole seconds, like
+                    // traffic_generator
+  ARRIVAL_POISSON,  // exponential gaps at ratePerHour
+  ARRIVAL_PLATOON   // Poisson platoons of geometric size, 'headway' apart
+} ArrivalModel;
+
+// Time-of-day demand curve scaling the Poisson and platoon rates. Simulated
+// time 0 is midnight and the curve repeats every 24 h
+typedef enum {
+  PROFILE_FLAT,    // constant rate
+  PROFILE_COMMUTER // peaks around 08:00 and 17:00 at 2.2x the mean rate
+} DemandProfile;
+
+typedef struct {
+  ArrivalModel model;
+  DemandProfile profile;
+  int minInterval; // ARRIVAL_INTERVAL, seconds
+  int maxInterval;
+  double ratePerHour; // ARRIVAL_POISSON / ARRIVAL_PLATOON mean demand
+  double platoonSize; // ARRIVAL_PLATOON mean vehicles per platoon (>= 1)
+  SimTime headway;    // ARRIVAL_PLATOON gap between vehicles of a platoon
+} ArrivalSpec;
+
+// Arrival times of one lane with its own random stream. Not thread-safe:
+// each stream belongs to one thread
+typedef struct {
+  ArrivalSpec spec;
+  Rng rng;
+  SimTime next;    // time of the next arrival
+  int platoonLeft; // vehicles still to come in the current platoon
+  SimTime nextPlatoon; // start of the next platoon
+} ArrivalStream;
+
+// Starts a stream at time 'start'. The first arrival is drawn from the model
+// (ARRIVAL_INTERVAL staggers it by 0-2 s like the generator)
+void initArrivalStream(ArrivalStream *s, const ArrivalSpec *spec, Rng *parent,
+                       SimTime start);
+
+// Returns the next arrival time and advances the stream
+SimTime nextArrival(ArrivalStream *s);
+
+// Bulk form: writes the arrival times before 'until' into 'times' (at most
+// 'max') and returns how many were written
+size_t generateArrivals(ArrivalStream *s, SimTime until, SimTime *times,
+                        size_t max);
+
+// Mean vehicles per hour the spec produces, over a whole day
+double meanArrivalRate(const ArrivalSpec *spec);
+
+// "flat" / "commuter", returns -1 for unknown names
+int parseDemandProfile(const char *name, DemandProfile *out);
+
+#endif
@@ -0,0 +1,276 @@
+#include "batch.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_sim.h"
+#include "junction.h"
+
+const char *METRIC_NAMES[METRIC_COUNT] = {
+    "served", "waiting", "priority_max_queue", "normal_max_queue",
+    "activations", "wait_p95_s"};
+
+// Two-sided 95% Student t critical values for 1..30 degrees of freedom
+static const double T_95[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+static double tCritical95(int df) {
+  if (df < 1)
+    return 0;
+  if (df <= 30)
+    return T_95[df - 1];
+  if (df <= 60)
+    return 2.000;
+  if (df <= 120)
+    return 1.980;
+  return 1.960;
+}
+
+typedef struct {
+  const BatchConfig *cfg;
+  const BatchResult *result;
+  double *samples; // [task][METRIC_COUNT]
+  atomic_int nextTask;
+  atomic_int failed;
+} BatchWork;
+
+// One replication: a fresh junction with the scenario's thresholds, run in
+// simulated time on RNG stream 'run'
+static int runReplication(const BatchConfig *cfg, const ScenarioResult *sc,
+                          int run, double *sample) {
+  JunctionConfig jc;
+  if (copyJunctionConfig(&jc, cfg->junction) < 0)
+    return -1;
+  for (int i = 0; i < jc.laneCount; i++) {
+    if (jc.lanes[i].priorityOn > 0) {
+      jc.lanes[i].priorityOn = sc->priorityOn;
+      jc.lanes[i].priorityOff = sc->priorityOff;
+    }
+  }
+
+  Junction *j = createJunction(&jc);
+  freeJunctionConfig(&jc);
+  if (!j)
+    return -1;
+
+  SimConfig sim = {cfg->duration, cfg->seed, NULL, (uint64_t)run};
+  SimStats stats;
+  if (runEventSimulation(j, &sim, &stats) < 0) {
+    freeJunction(j);
+    return -1;
+  }
+
+  LatencyHistogram *wait = (LatencyHistogram *)malloc(sizeof(LatencyHistogram));
+  if (!wait) {
+    freeJunction(j);
+    return -1;
+  }
+  initLatencyHistogram(wait);
+
+  memset(sample, 0, sizeof(double) * METRIC_COUNT);
+  for (int i = 0; i < j->config.laneCount; i++) {
+    const JunctionLane *lane = &j->lanes[i];
+    int metric = j->config.lanes[i].priorityOn > 0 ? METRIC_PRIORITY_QUEUE
+                                                   : METRIC_NORMAL_QUEUE;
+    sample[METRIC_SERVED] += lane->served;
+    sample[METRIC_WAITING] += getSize(lane->queue);
+    if (lane->maxQueue > sample[metric])
+      sample[metric] = lane->maxQueue;
+    mergeLatency(wait, &lane->wait);
+  }
+  sample[METRIC_ACTIVATIONS] = stats.priorityActivations;
+  sample[METRIC_WAIT_P95] =
+      (double)latencyPercentile(wait, 95) / NSEC_PER_SEC;
+
+  free(wait);
+  freeJunction(j);
+  return 0;
+}
+
+static void *batchWorker(void *arg) {
+  BatchWork *work = (BatchWork *)arg;
+  const BatchResult *r = work->result;
+  int tasks = r->scenarioCount * r->runs;
+
+  for (;;) {
+    int task = atomic_fetch_add(&work->nextTask, 1);
+    if (task >= tasks)
+      break;
+    const ScenarioResult *sc = &r->scenarios[task / r->runs];
+    if (runReplication(work->cfg, sc, task % r->runs,
+                       &work->samples[task * METRIC_COUNT]) < 0)
+      atomic_store(&work->failed, 1);
+  }
+  return NULL;
+}
+
+static void summarize(const double *samples, int runs, int metric,
+                      MetricSummary *out) {
+  // Welford's running mean/variance
+  double mean = 0, m2 = 0;
+  for (int r = 0; r < runs; r++) {
+    double x = samples[r * METRIC_COUNT + metric];
+    double delta = x - mean;
+    mean += delta / (r + 1);
+    m2 += delta * (x - mean);
+  }
+
+  out->mean = mean;
+  out->stddev = runs > 1 ? sqrt(m2 / (runs - 1)) : 0;
+  out->ci95 = runs > 1 ? tCritical95(runs - 1) * out->stddev / sqrt(runs) : 0;
+}
+
+// Lists the (on, off) pairs to simulate
+static int buildScenarios(const BatchConfig *cfg, BatchResult *r) {
+  int defaultOn = 0, defaultOff = 0;
+  for (int i = 0; i < cfg->junction->laneCount; i++) {
+    if (cfg->junction->lanes[i].priorityOn > 0) {
+      defaultOn = cfg->junction->lanes[i].priorityOn;
+      defaultOff = cfg->junction->lanes[i].priorityOff;
+      break;
+    }
+  }
+
+  int onMin = cfg->onMin > 0 ? cfg->onMin : defaultOn;
+  int onMax = cfg->onMax > 0 ? cfg->onMax : onMin;
+  int offMin = cfg->offMin > 0 ? cfg->offMin : defaultOff;
+  int offMax = cfg->offMax > 0 ? cfg->offMax : offMin;
+  if ((cfg->onMin > 0 || cfg->offMin > 0) && defaultOn == 0) {
+    printf("Error: The junction has no priority lane to sweep\n");
+    return -1;
+  }
+
+  int capacity = (onMax - onMin + 1) * (offMax - offMin + 1);
+  r->scenarios = (ScenarioResult *)calloc(capacity > 0 ? capacity : 1,
+                                          sizeof(ScenarioResult));
+  if (!r->scenarios) {
+    printf("Error: Failed to allocate memory for batch results\n");
+    return -1;
+  }
+
+  for (int on = onMin; on <= onMax; on++) {
+    for (int off = offMin; off <= offMax && off <= on; off++) {
+      r->scenarios[r->scenarioCount].priorityOn = on;
+      r->scenarios[r->scenarioCount].priorityOff = off;
+      r->scenarioCount++;
+    }
+  }
+
+  if (r->scenarioCount == 0) {
+    printf("Error: The sweep has no scenario with off <= on\n");
+    return -1;
+  }
+  return 0;
+}
+
+int runBatch(const BatchConfig *cfg, BatchResult *out) {
+  memset(out, 0, sizeof(*out));
+  if (cfg->runs < 1 || cfg->duration <= 0) {
+    printf("Error: A batch needs at least one run and a duration\n");
+    return -1;
+  }
+  out->runs = cfg->runs;
+  out->duration = cfg->duration;
+  if (buildScenarios(cfg, out) < 0) {
+    freeBatchResult(out);
+    return -1;
+  }
+
+  int tasks = out->scenarioCount * out->runs;
+  out->threads = cfg->threads < 1 ? 1 : cfg->threads;
+  if (out->threads > tasks)
+    out->threads = tasks;
+
+  BatchWork work = {cfg, out, NULL, 0, 0};
+  work.samples = (double *)malloc(sizeof(double) * METRIC_COUNT * tasks);
+  pthread_t *workers = (pthread_t *)malloc(sizeof(pthread_t) * out->threads);
+  if (!work.samples || !workers) {
+    printf("Error: Failed to allocate memory for batch results\n");
+    free(work.samples);
+    free(workers);
+    freeBatchResult(out);
+    return -1;
+  }
+
+  SimTime wallStart = monotonicNs();
+  for (int t = 0; t < out->threads; t++)
+    pthread_create(&workers[t], NULL, batchWorker, &work);
+  for (int t = 0; t < out->threads; t++)
+    pthread_join(workers[t], NULL);
+  out->wallSeconds = (double)(monotonicNs() - wallStart) / NSEC_PER_SEC;
+
+  // Aggregated in task order, so the output doesn't depend on scheduling
+  for (int s = 0; s < out->scenarioCount; s++) {
+    for (int m = 0; m < METRIC_COUNT; m++)
+      summarize(&work.samples[s * out->runs * METRIC_COUNT], out->runs, m,
+                &out->scenarios[s].metrics[m]);
+  }
+
+  int failed = atomic_load(&work.failed);
+  free(work.samples);
+  free(workers);
+  if (failed) {
+    printf("Error: Some replications failed\n");
+    return -1;
+  }
+  return 0;
+}
+
+void printBatchResult(FILE *out, const BatchResult *r) {
+  fprintf(out,
+          "=== %d scenarios x %d runs of %.0f s in %.3f s wall time (%d "
+          "threads) ===\n",
+          r->scenarioCount, r->runs, (double)r->duration / NSEC_PER_SEC,
+          r->wallSeconds, r->threads);
+  fprintf(out, "Mean +- 95%% confidence interval per run\n");
+  fprintf(out, " On Off");
+  for (int m = 0; m < METRIC_COUNT; m++)
+    fprintf(out, " %21s", METRIC_NAMES[m]);
+  fprintf(out, "\n");
+
+  for (int s = 0; s < r->scenarioCount; s++) {
+    const ScenarioResult *sc = &r->scenarios[s];
+    fprintf(out, "%3d %3d", sc->priorityOn, sc->priorityOff);
+    for (int m = 0; m < METRIC_COUNT; m++)
+      fprintf(out, " %10.1f +- %7.1f", sc->metrics[m].mean,
+              sc->metrics[m].ci95);
+    fprintf(out, "\n");
+  }
+}
+
+int writeBatchCsv(const char *path, const BatchResult *r) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    perror("Error opening metrics file");
+    return -1;
+  }
+
+  fprintf(file, "priority_on,priority_off,runs");
+  for (int m = 0; m < METRIC_COUNT; m++)
+    fprintf(file, ",%s_mean,%s_stddev,%s_ci95", METRIC_NAMES[m],
+            METRIC_NAMES[m], METRIC_NAMES[m]);
+  fprintf(file, "\n");
+
+  for (int s = 0; s < r->scenarioCount; s++) {
+    const ScenarioResult *sc = &r->scenarios[s];
+    fprintf(file, "%d,%d,%d", sc->priorityOn, sc->priorityOff, r->runs);
+    for (int m = 0; m < METRIC_COUNT; m++)
+      fprintf(file, ",%.3f,%.3f,%.3f", sc->metrics[m].mean,
+              sc->metrics[m].stddev, sc->metrics[m].ci95);
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  return 0;
+}
+
+void freeBatchResult(BatchResult *r) {
+  free(r->scenarios);
+  r->scenarios = NULL;
+  r->scenarioCount = 0;
+}
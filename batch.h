@@ -0,0 +1,66 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "junction_config.h"
+#include "sim_time.h"
+
+// Per-replication results, aggregated over the runs of a scenario
+typedef enum {
+  METRIC_SERVED,         // vehicles served, all lanes
+  METRIC_WAITING,        // vehicles still queued at the end
+  METRIC_PRIORITY_QUEUE, // longest queue seen on a priority lane
+  METRIC_NORMAL_QUEUE,   // longest queue seen on a normal lane
+  METRIC_ACTIVATIONS,    // priority mode activations
+  METRIC_WAIT_P95,       // 95th percentile wait over all lanes, seconds
+  METRIC_COUNT
+} BatchMetric;
+
+typedef struct {
+  const JunctionConfig *junction;
+  SimTime duration;
+  uint64_t seed; // master seed, replication r uses stream r in every scenario
+  int runs;      // replications per scenario
+  int threads;
+
+  // Priority threshold sweep applied to every priority lane, 0 = only the
+  // thresholds of the config. Scenarios with off > on are skipped
+  int onMin, onMax;
+  int offMin, offMax;
+} BatchConfig;
+
+typedef struct {
+  double mean;
+  double stddev;
+  double ci95; // half-width of the 95% confidence interval of the mean
+} MetricSummary;
+
+typedef struct {
+  int priorityOn;
+  int priorityOff;
+  MetricSummary metrics[METRIC_COUNT];
+} ScenarioResult;
+
+typedef struct {
+  int scenarioCount;
+  ScenarioResult *scenarios;
+  int runs;
+  int threads;
+  SimTime duration;
+  double wallSeconds;
+} BatchResult;
+
+extern const char *METRIC_NAMES[METRIC_COUNT];
+
+// Runs every scenario 'runs' times on a pool of worker threads. Results only
+// depend on the seed, not on the thread count. Returns 0 on success
+int runBatch(const BatchConfig *cfg, BatchResult *out);
+
+void printBatchResult(FILE *out, const BatchResult *r);
+// One row per scenario with the mean and CI of every metric
+int writeBatchCsv(const char *path, const BatchResult *r);
+void freeBatchResult(BatchResult *r);
+
+#endif
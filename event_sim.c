@@ -0,0 +1,297 @@
+#include "event_sim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "signal_control.h"
+
+EventHeap *createEventHeap() {
+  EventHeap *h = (EventHeap *)malloc(sizeof(EventHeap));
+  if (!h) {
+    printf("Error: Failed to allocate memory for event heap\n");
+    return NULL;
+  }
+  h->capacity = 64;
+  h->size = 0;
+  h->nextSeq = 0;
+  h->events = (Event *)malloc(sizeof(Event) * h->capacity);
+  if (!h->events) {
+    printf("Error: Failed to allocate memory for event heap\n");
+    free(h);
+    return NULL;
+  }
+  return h;
+}
+
+void freeEventHeap(EventHeap *h) {
+  if (!h)
+    return;
+  free(h->events);
+  free(h);
+}
+
+// Events at the same time fire in the order they were scheduled. In a network
+// ties go by junction, then by the junction that scheduled the event and its
+// sequence number there, so the order never depends on how the network is
+// split across threads
+static bool eventBefore(const Event *a, const Event *b) {
+  if (a->time != b->time)
+    return a->time < b->time;
+  if (a->junction != b->junction)
+    return a->junction < b->junction;
+  if (a->source != b->source)
+    return a->source < b->source;
+  return a->seq < b->seq;
+}
+
+int pushEvent(EventHeap *h, SimTime time, EventType type, int lane) {
+  if (!h)
+    return -1;
+  Event e = {time, h->nextSeq++, 0, type, 0, lane, NO_VEHICLE};
+  return insertEvent(h, &e);
+}
+
+int insertEvent(EventHeap *h, const Event *event) {
+  if (!h)
+    return -1;
+
+  if (h->size == h->capacity) {
+    int newCapacity = h->capacity * 2;
+    Event *grown = (Event *)realloc(h->events, sizeof(Event) * newCapacity);
+    if (!grown) {
+      printf("Error: Failed to grow event heap\n");
+      return -1;
+    }
+    h->events = grown;
+    h->capacity = newCapacity;
+  }
+
+  // Sift up
+  Event e = *event;
+  int i = h->size++;
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!eventBefore(&e, &h->events[parent]))
+      break;
+    h->events[i] = h->events[parent];
+    i = parent;
+  }
+  h->events[i] = e;
+  return 0;
+}
+
+bool popEvent(EventHeap *h, Event *out) {
+  if (!h || h->size == 0)
+    return false;
+
+  *out = h->events[0];
+  Event last = h->events[--h->size];
+
+  // Sift down
+  int i = 0;
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= h->size)
+      break;
+    if (child + 1 < h->size &&
+        eventBefore(&h->events[child + 1], &h->events[child]))
+      child++;
+    if (!eventBefore(&h->events[child], &last))
+      break;
+    h->events[i] = h->events[child];
+    i = child;
+  }
+  h->events[i] = last;
+  return true;
+}
+
+// Same format as traffic_generator: 2 letters + 1 digit + 2 letters + 3 digits
+void generateVehicleNumber(char *buffer, Rng *rng) {
+  buffer[0] = 'A' + rngBelow(rng, 26);
+  buffer[1] = 'A' + rngBelow(rng, 26);
+  buffer[2] = '0' + rngBelow(rng, 10);
+  buffer[3] = 'A' + rngBelow(rng, 26);
+  buffer[4] = 'A' + rngBelow(rng, 26);
+  buffer[5] = '0' + rngBelow(rng, 10);
+  buffer[6] = '0' + rngBelow(rng, 10);
+  buffer[7] = '0' + rngBelow(rng, 10);
+  buffer[8] = '\0';
+}
+
+// Queues an arriving vehicle on lane i, the junction keeps the counters
+static void arriveVehicle(Junction *j, int i, VehicleId v) {
+  VEHICLE_FIELD(j->pool, v, road) = j->config.lanes[i].road;
+  VEHICLE_FIELD(j->pool, v, lane) = (unsigned char)j->config.lanes[i].laneNumber;
+  if (junctionEnqueue(j, v) < 0)
+    poolFree(j->pool, v);
+}
+
+// Keeps one pending arrival per lane on the heap
+static void scheduleArrival(EventHeap *heap, ArrivalStream *s, int lane) {
+  SimTime t = nextArrival(s);
+  if (t != INT64_MAX)
+    pushEvent(heap, t, EVENT_ARRIVAL, lane);
+}
+
+// Schedules the next replayed record with a known lane, false when done
+static bool scheduleReplay(Junction *j, EventHeap *heap, const VehicleLog *log,
+                           size_t *cursor, int64_t baseNs) {
+  for (; *cursor < log->count; (*cursor)++) {
+    const VehicleRecord *rec = &log->records[*cursor];
+    int lane = findLane(j, rec->road, rec->lane);
+    if (lane >= 0) {
+      pushEvent(heap, rec->timestampNs - baseNs, EVENT_REPLAY, lane);
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool junctionIsEmpty(Junction *j) {
+  for (int i = 0; i < j->config.laneCount; i++) {
+    if (!isEmpty(j->lanes[i].queue))
+      return false;
+  }
+  return true;
+}
+
+// Runs the junction in simulated time: no sleeps, every light change and
+// served vehicle is an event on the heap. Returns 0 on success
+int runEventSimulation(Junction *j, const SimConfig *cfg, SimStats *stats) {
+  SharedData sharedData = {0, false, j, NULL};
+  SignalController controller;
+  Rng rng;
+  ArrivalStream *arrivals = NULL;
+  const VehicleLog *replay = cfg->replay;
+  size_t cursor = 0;
+  int64_t baseNs = 0;
+  bool replaying = false;
+
+  EventHeap *heap = createEventHeap();
+  if (!heap)
+    return -1;
+
+  memset(stats, 0, sizeof(*stats));
+  j->priority->logChanges = false;
+  j->simulated = true;
+
+  initController(&controller, j, false);
+  rngSeed(&rng, cfg->seed, cfg->stream);
+
+  if (replay) {
+    // Recorded arrivals, one pending event at a time so the heap stays small
+    // however long the log is. Time 0 is the first record
+    if (replay->count > 0)
+      baseNs = replay->records[0].timestampNs;
+    replaying = scheduleReplay(j, heap, replay, &cursor, baseNs);
+  } else {
+    // One arrival stream per lane as described by the lane config (the
+    // defaults mirror traffic_generator: AL2 1s, BL2 1-2s, CL3 1-3s, DL4 2-3s)
+    arrivals = (ArrivalStream *)malloc(sizeof(ArrivalStream) *
+                                       j->config.laneCount);
+    if (!arrivals) {
+      printf("Error: Failed to allocate memory for arrival streams\n");
+      freeEventHeap(heap);
+      return -1;
+    }
+    for (int i = 0; i < j->config.laneCount; i++) {
+      initArrivalStream(&arrivals[i], &j->config.lanes[i].arrivals, &rng, 0);
+      scheduleArrival(heap, &arrivals[i], i);
+    }
+  }
+  pushEvent(heap, 0, EVENT_CONTROLLER, -1);
+
+  SimTime wallStart = monotonicNs();
+
+  Event e;
+  while (popEvent(heap, &e)) {
+    if (cfg->duration > 0 && e.time > cfg->duration)
+      break;
+    stats->events++;
+    stats->simulated = j->now = e.time;
+
+    if (e.type == EVENT_ARRIVAL) {
+      VehicleId v = poolAlloc(j->pool);
+      if (v != NO_VEHICLE) {
+        generateVehicleNumber(VEHICLE_FIELD(j->pool, v, vehicleNumber), &rng);
+        VEHICLE_FIELD(j->pool, v, generatedAt) = e.time;
+        VEHICLE_FIELD(j->pool, v, ingestedAt) = e.time;
+        arriveVehicle(j, e.lane, v);
+      }
+      scheduleArrival(heap, &arrivals[e.lane], e.lane);
+    } else if (e.type == EVENT_REPLAY) {
+      const VehicleRecord *rec = &replay->records[cursor++];
+      VehicleId v = poolAlloc(j->pool);
+      if (v != NO_VEHICLE) {
+        char *plate = VEHICLE_FIELD(j->pool, v, vehicleNumber);
+        memcpy(plate, rec->plate, PLATE_LENGTH);
+        plate[PLATE_LENGTH] = '\0';
+        VEHICLE_FIELD(j->pool, v, generatedAt) = e.time;
+        VEHICLE_FIELD(j->pool, v, ingestedAt) = e.time;
+        arriveVehicle(j, e.lane, v);
+      }
+      replaying = scheduleReplay(j, heap, replay, &cursor, baseNs);
+    } else {
+      // Without a duration a replay runs until every recorded vehicle is served
+      bool drained = replay && !replaying && junctionIsEmpty(j);
+      if (cfg->duration <= 0 && drained)
+        break;
+
+      SimTime delay = controllerStep(&controller, &sharedData, j);
+      pushEvent(heap, e.time + delay, EVENT_CONTROLLER, -1);
+    }
+  }
+
+  stats->wallSeconds = (double)(monotonicNs() - wallStart) / NSEC_PER_SEC;
+  stats->priorityActivations = controller.priorityActivations;
+  stats->pool = getPoolStats(j->pool);
+
+  free(arrivals);
+  freeEventHeap(heap);
+  return 0;
+}
+
+void printSimStats(FILE *out, const Junction *j, const SimStats *s) {
+  fprintf(out, "=== Simulated %.0f s in %.3f s wall time (%ld events) ===\n",
+          (double)s->simulated / NSEC_PER_SEC, s->wallSeconds, s->events);
+  fprintf(out, "Lane  Arrived  Dropped  Served  Waiting  MaxQueue\n");
+  for (int i = 0; i < j->config.laneCount; i++) {
+    const JunctionLane *lane = &j->lanes[i];
+    fprintf(out, "%-5s %7ld  %7ld  %6ld  %7d  %8d\n", j->config.lanes[i].name,
+            lane->arrivals, lane->dropped, lane->served,
+            getSize(lane->queue), lane->maxQueue);
+  }
+  printWaitTable(out, j, s->simulated);
+  printFlowTable(out, j);
+  fprintf(out, "Signal policy: %s\n", j->config.policy);
+  fprintf(out, "Priority mode activations: %ld\n", s->priorityActivations);
+  printPoolStats(out, &s->pool);
+}
+
+// One row per lane, so results from many runs can be concatenated
+int writeSimStatsCsv(const char *path, const Junction *j, const SimStats *s) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    perror("Error opening metrics file");
+    return -1;
+  }
+
+  double hours = (double)s->simulated / (3600 * NSEC_PER_SEC);
+  fprintf(file, "lane,arrived,dropped,served,waiting,max_queue,"
+                "served_per_hour,%s,%s\n",
+          LATENCY_CSV_HEADER, FLOW_CSV_HEADER);
+  for (int i = 0; i < j->config.laneCount; i++) {
+    const JunctionLane *lane = &j->lanes[i];
+    LatencySummary wait = getLatencySummary(&lane->wait);
+    fprintf(file, "%s,%ld,%ld,%ld,%d,%d,%.1f,", j->config.lanes[i].name,
+            lane->arrivals, lane->dropped, lane->served, getSize(lane->queue),
+            lane->maxQueue, hours > 0 ? lane->served / hours : 0);
+    writeLatencyCsv(file, &wait);
+    fprintf(file, ",");
+    writeFlowCsv(file, &lane->flow);
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef EVENT_SIM_H
+#define EVENT_SIM_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "arrivals.h"
+#include "junction.h"
+#include "rng.h"
+#include "sim_time.h"
+#include "vehicle_log.h"
+
+typedef enum {
+  EVENT_ARRIVAL,   // generated arrival on 'lane'
+  EVENT_REPLAY,    // next record of the replayed log, on 'lane'
+  EVENT_CONTROLLER, // next signal controller step
+  EVENT_TRANSFER    // 'vehicle' reaches 'lane' of a downstream junction
+} EventType;
+
+typedef struct {
+  SimTime time;
+  unsigned long seq; // tie-breaker so equal times stay FIFO
+  int source;        // junction that scheduled the event, seq counts there
+  EventType type;
+  int junction; // junction index in a network, 0 for a single junction
+  int lane;
+  VehicleId vehicle; // EVENT_TRANSFER only, else NO_VEHICLE
+} Event;
+
+typedef struct {
+  Event *events;
+  int size;
+  int capacity;
+  unsigned long nextSeq;
+} EventHeap;
+
+typedef struct {
+  SimTime duration; // stop after this much simulated time, 0 = until the
+                    // replay is consumed and every vehicle served
+  uint64_t seed;
+  const VehicleLog *replay; // recorded arrivals instead of generated ones
+  uint64_t stream;          // RNG stream of the seed, one per replication
+} SimConfig;
+
+typedef struct {
+  SimTime simulated;
+  double wallSeconds;
+  long events;
+  long priorityActivations;
+  VehiclePoolStats pool;
+} SimStats;
+
+// Event heap (min-heap on time)
+EventHeap *createEventHeap();
+int pushEvent(EventHeap *h, SimTime time, EventType type, int lane);
+// Adds a fully keyed event (the caller assigns seq and source)
+int insertEvent(EventHeap *h, const Event *e);
+bool popEvent(EventHeap *h, Event *out);
+void freeEventHeap(EventHeap *h);
+
+// Same format as traffic_generator, shared with the network simulation
+void generateVehicleNumber(char *buffer, Rng *rng);
+
+// Runs the junction in simulated time as fast as possible
+int runEventSimulation(Junction *j, const SimConfig *cfg, SimStats *stats);
+
+// Per-lane counters are read from the junction, run-wide ones from the stats
+void printSimStats(FILE *out, const Junction *j, const SimStats *s);
+int writeSimStatsCsv(const char *path, const Junction *j, const SimStats *s);
+
+#endif
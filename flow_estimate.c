@@ -0,0 +1,59 @@
+#include "flow_estimate.h"
+
+#include <math.h>
+#include <string.h>
+
+void initFlowEstimate(FlowEstimate *f, double priorHeadway) {
+  memset(f, 0, sizeof(*f));
+  f->headway = priorHeadway;
+  f->lastServe = -1;
+  f->lastSample = -1;
+}
+
+void startGreen(FlowEstimate *f) {
+  f->lastServe = -1;
+  f->queuedBehind = false;
+}
+
+void observeService(FlowEstimate *f, SimTime now, int remaining) {
+  if (f->lastServe >= 0 && f->queuedBehind) {
+    double sample = (double)(now - f->lastServe) / NSEC_PER_SEC;
+    f->headway += FLOW_HEADWAY_ALPHA * (sample - f->headway);
+    f->headwaySamples++;
+  }
+  f->lastServe = now;
+  f->queuedBehind = remaining > 0;
+}
+
+// Irregular sampling, so the EWMA weight grows with the time since the last
+// sample; the first interval sets the rate outright
+void observeArrivals(FlowEstimate *f, long arrivals, SimTime now) {
+  if (f->lastSample >= 0 && now > f->lastSample) {
+    double seconds = (double)(now - f->lastSample) / NSEC_PER_SEC;
+    double rate = (arrivals - f->lastArrivals) * 3600.0 / seconds;
+    double alpha =
+        f->demandSamples > 0 ? 1 - exp(-seconds / FLOW_DEMAND_TAU_SEC) : 1;
+    f->demand += alpha * (rate - f->demand);
+    f->demandSamples++;
+  }
+  f->lastArrivals = arrivals;
+  f->lastSample = now;
+}
+
+double saturationFlow(const FlowEstimate *f) {
+  return f->headway > 0 ? 3600.0 / f->headway : 0;
+}
+
+double flowRatio(const FlowEstimate *f) {
+  double s = saturationFlow(f);
+  return s > 0 ? f->demand / s : 0;
+}
+
+void writeFlowCsv(FILE *out, const FlowEstimate *f) {
+  fprintf(out, "%.1f,%.3f,", saturationFlow(f), f->headway);
+  if (f->demandSamples > 0)
+    fprintf(out, "%.1f", f->demand);
+  fprintf(out, ",");
+  if (f->green > 0)
+    fprintf(out, "%.1f", f->green);
+}
@@ -0,0 +1,51 @@
+#ifndef FLOW_ESTIMATE_H
+#define FLOW_ESTIMATE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "sim_time.h"
+
+#define FLOW_HEADWAY_ALPHA 0.1    // EWMA weight of each saturated headway
+#define FLOW_DEMAND_TAU_SEC 300.0 // time constant of the arrival-rate EWMA
+
+// Online estimate of one lane's saturation flow and demand. Written by the
+// controller thread; the headway only learns from vehicles that left while
+// the one behind was already queued, so empty-lane gaps don't count
+typedef struct {
+  double headway;    // EWMA saturation headway in s
+  long headwaySamples;
+  double demand;     // EWMA arrivals per hour
+  long demandSamples;
+  double green;      // last green split planned for the lane's road, s
+
+  SimTime lastServe; // previous service in the current green, -1 = none
+  bool queuedBehind; // the lane still held vehicles after that service
+  long lastArrivals; // arrival counter at the previous demand sample
+  SimTime lastSample;
+} FlowEstimate;
+
+// Starts from a prior headway (the configured one)
+void initFlowEstimate(FlowEstimate *f, double priorHeadway);
+
+// A green starts on the lane: the next service has no predecessor
+void startGreen(FlowEstimate *f);
+
+// A vehicle left at 'now' with 'remaining' still queued
+void observeService(FlowEstimate *f, SimTime now, int remaining);
+
+// Updates the demand from the lane's arrival counter
+void observeArrivals(FlowEstimate *f, long arrivals, SimTime now);
+
+// Vehicles per hour of green the lane discharges when saturated
+double saturationFlow(const FlowEstimate *f);
+
+// Demand over saturation flow (the lane's flow ratio y), 0 without samples
+double flowRatio(const FlowEstimate *f);
+
+// CSV fields of an estimate, without a line break; demand and green are
+// empty until known
+#define FLOW_CSV_HEADER "sat_flow_per_hour,headway_s,demand_per_hour,green_s"
+void writeFlowCsv(FILE *out, const FlowEstimate *f);
+
+#endif
@@ -0,0 +1,39 @@
+#include "frame_clock.h"
+
+void initFrameClock(FrameClock *c, int framesPerSecond) {
+  c->period = NSEC_PER_SEC / (framesPerSecond > 0 ? framesPerSecond
+                                                  : DEFAULT_FRAME_RATE);
+  c->next = monotonicNs() + c->period;
+  c->frames = 0;
+  c->drawn = 0;
+  c->dropped = 0;
+  initLatencyHistogram(&c->render);
+  initLatencyHistogram(&c->present);
+  initLatencyHistogram(&c->events);
+}
+
+void waitForFrame(FrameClock *c) {
+  SimTime now = monotonicNs();
+  c->frames++;
+  if (now > c->next) {
+    SimTime missed = (now - c->next) / c->period + 1;
+    c->dropped += missed;
+    c->next += missed * c->period;
+  }
+  sleepNs(c->next - now);
+  c->next += c->period;
+}
+
+void printFrameStats(FILE *out, const FrameClock *c) {
+  fprintf(out, "Frames: %ld drawn of %ld at %.0f per s, %ld dropped\n",
+          c->drawn, c->frames, (double)NSEC_PER_SEC / c->period, c->dropped);
+  LatencySummary render = getLatencySummary(&c->render);
+  LatencySummary present = getLatencySummary(&c->present);
+  LatencySummary events = getLatencySummary(&c->events);
+  printLatencyLine(out, "  render", &render);
+  fprintf(out, "\n");
+  printLatencyLine(out, "  present", &present);
+  fprintf(out, "\n");
+  printLatencyLine(out, "  events", &events);
+  fprintf(out, "\n");
+}
@@ -0,0 +1,36 @@
+#ifndef FRAME_CLOCK_H
+#define FRAME_CLOCK_H
+
+#include <stdio.h>
+
+#include "latency.h"
+#include "sim_time.h"
+
+#define DEFAULT_FRAME_RATE 60
+
+// Paces a render loop on CLOCK_MONOTONIC deadlines, one every 'period'. A
+// loop that overruns drops the deadlines it missed instead of rushing to
+// catch up, and the time spent in each part of a frame goes into
+// histograms. UI thread only, readable like any LatencyHistogram
+typedef struct {
+  SimTime period;
+  SimTime next;  // deadline of the next frame
+  long frames;   // loop iterations
+  long drawn;    // frames actually rendered and presented
+  long dropped;  // deadlines missed
+  LatencyHistogram render;  // drawing the frame
+  LatencyHistogram present; // SDL_RenderPresent, incl. waiting for vsync
+  LatencyHistogram events;  // handling input and window events
+} FrameClock;
+
+void initFrameClock(FrameClock *c, int framesPerSecond);
+
+// Sleeps until the next deadline. If the loop is already past it, the
+// missed deadlines are counted as dropped and the next one in the future
+// is used
+void waitForFrame(FrameClock *c);
+
+// "Frames: ..." followed by one line per histogram
+void printFrameStats(FILE *out, const FrameClock *c);
+
+#endif
@@ -0,0 +1,158 @@
+#include "junction.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+Junction *createJunction(const JunctionConfig *cfg) {
+  Junction *j = (Junction *)calloc(1, sizeof(Junction));
+  if (!j) {
+    printf("Error: Failed to allocate memory for junction\n");
+    return NULL;
+  }
+  if (copyJunctionConfig(&j->config, cfg) < 0) {
+    free(j);
+    return NULL;
+  }
+
+  j->lanes = (JunctionLane *)calloc(cfg->laneCount, sizeof(JunctionLane));
+  j->pool = createVehiclePool();
+  j->priority = createPriorityQueue(cfg->laneCount);
+  if (!j->lanes || !j->pool || !j->priority) {
+    freeJunction(j);
+    return NULL;
+  }
+
+  for (int i = 0; i < cfg->laneCount; i++) {
+    const LaneConfig *lane = &j->config.lanes[i];
+    j->lanes[i].queue = createQueue();
+    if (!j->lanes[i].queue) {
+      freeJunction(j);
+      return NULL;
+    }
+    setPriorityLane(j->priority, i, lane->name, lane->priorityOn,
+                    lane->priorityOff, lane->weight);
+    initFlowEstimate(&j->lanes[i].flow,
+                     (double)lane->headway / NSEC_PER_SEC);
+  }
+
+  return j;
+}
+
+void freeJunction(Junction *j) {
+  if (!j)
+    return;
+
+  // Queued vehicles live in the pool and are released together with it
+  for (int i = 0; j->lanes && i < j->config.laneCount; i++)
+    freeQueue(j->lanes[i].queue);
+  free(j->lanes);
+  freeVehiclePool(j->pool);
+  freePriorityQueue(j->priority);
+  freeJunctionConfig(&j->config);
+  free(j);
+}
+
+int roadIndex(const Junction *j, char road) {
+  for (int i = 0; i < j->config.roadCount; i++) {
+    if (j->config.roads[i].id == road)
+      return i;
+  }
+  return -1;
+}
+
+int findLane(const Junction *j, char road, int laneNumber) {
+  int r = roadIndex(j, road);
+  if (r < 0)
+    return -1;
+
+  const RoadConfig *rc = &j->config.roads[r];
+  if (laneNumber == 0)
+    return rc->firstLane;
+  for (int i = rc->firstLane; i < rc->firstLane + rc->laneCount; i++) {
+    if (j->config.lanes[i].laneNumber == laneNumber)
+      return i;
+  }
+  return -1;
+}
+
+int roadVehicleCount(const Junction *j, int road) {
+  const RoadConfig *rc = &j->config.roads[road];
+  int count = 0;
+  for (int i = rc->firstLane; i < rc->firstLane + rc->laneCount; i++)
+    count += getSize(j->lanes[i].queue);
+  return count;
+}
+
+int junctionEnqueue(Junction *j, VehicleId v) {
+  char road = VEHICLE_FIELD(j->pool, v, road);
+  int laneNumber = VEHICLE_FIELD(j->pool, v, lane);
+  int i = findLane(j, road, laneNumber);
+  if (i < 0) {
+    printf("Warning: Unknown lane %c%d for vehicle %s\n", road, laneNumber,
+           VEHICLE_FIELD(j->pool, v, vehicleNumber));
+    return -1;
+  }
+
+  JunctionLane *lane = &j->lanes[i];
+  VEHICLE_FIELD(j->pool, v, queuedAt) = junctionTime(j);
+  if (enqueue(lane->queue, v) < 0) {
+    lane->dropped++;
+    return -1;
+  }
+  lane->arrivals++;
+  int size = getSize(lane->queue);
+  if (size > lane->maxQueue)
+    lane->maxQueue = size;
+
+  // Under an event engine the controller runs on this thread, so the lane
+  // heap can follow every arrival; real-time controllers sync themselves
+  if (j->simulated)
+    updatePriority(j->priority, i, size, laneHeadQueuedAt(j, i));
+  return 0;
+}
+
+SimTime laneHeadQueuedAt(const Junction *j, int lane) {
+  VehicleId head = peek(j->lanes[lane].queue);
+  return head != NO_VEHICLE ? VEHICLE_FIELD(j->pool, head, queuedAt)
+                            : INT64_MAX;
+}
+
+void syncPriorities(Junction *j) {
+  for (int i = 0; i < j->config.laneCount; i++) {
+    int count = getSize(j->lanes[i].queue);
+    if (count != j->priority->lanes[i].vehicleCount)
+      updatePriority(j->priority, i, count, laneHeadQueuedAt(j, i));
+  }
+}
+
+void printWaitTable(FILE *out, const Junction *j, SimTime elapsed) {
+  double hours = (double)elapsed / (3600 * NSEC_PER_SEC);
+  fprintf(out, "Lane     Veh/h    Mean     p50     p95     p99     Max  "
+               "(wait in s)\n");
+  for (int i = 0; i < j->config.laneCount; i++) {
+    const JunctionLane *lane = &j->lanes[i];
+    LatencySummary wait = getLatencySummary(&lane->wait);
+    fprintf(out, "%-5s %8.0f", j->config.lanes[i].name,
+            hours > 0 ? lane->served / hours : 0);
+    printLatencyColumns(out, &wait);
+    fprintf(out, "\n");
+  }
+}
+
+void printFlowTable(FILE *out, const Junction *j) {
+  fprintf(out, "Lane   SatFlow Headway  Demand       y   Green  "
+               "(flows in veh/h, times in s)\n");
+  for (int i = 0; i < j->config.laneCount; i++) {
+    const FlowEstimate *f = &j->lanes[i].flow;
+    fprintf(out, "%-5s %8.0f %7.2f", j->config.lanes[i].name,
+            saturationFlow(f), f->headway);
+    if (f->demandSamples > 0)
+      fprintf(out, " %7.0f %7.2f", f->demand, flowRatio(f));
+    else
+      fprintf(out, " %7s %7s", "-", "-");
+    if (f->green > 0)
+      fprintf(out, " %7.1f\n", f->green);
+    else
+      fprintf(out, " %7s\n", "-");
+  }
+}
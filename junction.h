@@ -0,0 +1,93 @@
+#ifndef JUNCTION_H
+#define JUNCTION_H
+
+#include <stdio.h>
+
+#include "flow_estimate.h"
+#include "junction_config.h"
+#include "latency.h"
+#include "queue.h"
+#include "vehicle_pool.h"
+
+// One approach lane: its queue plus counters. arrivals/dropped/maxQueue are
+// written by the producer, served, wait, credit and flow by the consumer
+typedef struct {
+  Queue *queue;
+  long arrivals;
+  long dropped;
+  long served;
+  int maxQueue;
+  LatencyHistogram wait; // time from joining the queue to being served
+  SimTime credit;        // green time banked towards the next departure
+  FlowEstimate flow;     // observed saturation flow and demand
+} JunctionLane;
+
+typedef struct Junction Junction;
+
+// Called by the controller with every served vehicle, which the hook then
+// owns. Without a hook served vehicles go straight back to the pool
+typedef void (*DepartureHook)(Junction *j, int lane, VehicleId v,
+                              void *ctx);
+
+// All lanes of a junction as described by its JunctionConfig, plus the lane
+// priorities. Lock-free: one reader thread enqueues and allocates vehicles,
+// one controller thread dequeues, frees and owns the priorities; anyone may
+// read queue sizes
+struct Junction {
+  JunctionConfig config;
+  JunctionLane *lanes; // config.laneCount entries
+  PriorityQueue *priority;
+  VehiclePool *pool;
+  DepartureHook onDeparture;
+  void *departureCtx;
+
+  // Generation to ingest of every vehicle a live reader took in, written by
+  // the reader thread. Queue waits are per lane
+  LatencyHistogram transport;
+  long malformed; // input records the reader rejected, reader thread only
+
+  // Clock for queue waits: CLOCK_MONOTONIC, or 'now' when an event
+  // simulation drives the junction and keeps it at the current event time
+  bool simulated;
+  SimTime now;
+};
+
+Junction *createJunction(const JunctionConfig *cfg);
+void freeJunction(Junction *j);
+
+// Maps a road letter to its index, -1 if unknown
+int roadIndex(const Junction *j, char road);
+
+// Maps road + lane number to a lane index. Lane number 0 means the road's
+// first lane. Returns -1 if the junction has no such lane
+int findLane(const Junction *j, char road, int laneNumber);
+
+// Vehicles waiting on all lanes of a road
+int roadVehicleCount(const Junction *j, int road);
+
+// Per-lane throughput over 'elapsed' and wait percentiles, in seconds
+void printWaitTable(FILE *out, const Junction *j, SimTime elapsed);
+
+// Per-lane saturation flow and demand estimates, flow ratio and last green
+void printFlowTable(FILE *out, const Junction *j);
+
+// Current time in the junction's clock (see Junction::simulated)
+static inline SimTime junctionTime(const Junction *j) {
+  return j->simulated ? j->now : monotonicNs();
+}
+
+// Queue time of the vehicle at the head of a lane, INT64_MAX if it is empty.
+// Controller (consumer) thread only
+SimTime laneHeadQueuedAt(const Junction *j, int lane);
+
+// Brings the lane heap up to date with the queues after arrivals from a
+// real-time reader. Controller thread only; O(lanes), plus O(log lanes) per
+// changed lane
+void syncPriorities(Junction *j);
+
+// Adds the vehicle to its lane's queue and stamps queuedAt. Reader
+// (producer) thread only.
+// Returns 0 on success, -1 if the lane is unknown or out of memory
+int junctionEnqueue(Junction *j, VehicleId v);
+
+#endif
@@ -0,0 +1,294 @@
+#include "junction_config.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "signal_control.h"
+
+#define MAX_CONFIG_LINE 256
+
+static const char *DEFAULT_JUNCTION =
+    "lane AL2 priority 7 4 interval 1 1\n"
+    "lane BL2 interval 1 2\n"
+    "lane CL3 interval 1 3\n"
+    "lane DL4 interval 2 3\n";
+
+// Parses "AL2" into road 'A' and lane 2
+static bool parseLaneName(const char *name, LaneConfig *lane) {
+  if (strlen(name) >= MAX_LANE_NAME || !isupper((unsigned char)name[0]) ||
+      name[1] != 'L' || !isdigit((unsigned char)name[2]))
+    return false;
+
+  char *end;
+  long number = strtol(name + 2, &end, 10);
+  if (*end != '\0' || number < 1 || number > 255)
+    return false;
+
+  strcpy(lane->name, name);
+  lane->road = name[0];
+  lane->laneNumber = (int)number;
+  return true;
+}
+
+// Adds one lane, keeping the lanes of each road contiguous and the roads in
+// order of first appearance
+static int addLane(JunctionConfig *cfg, const LaneConfig *lane) {
+  int r;
+  for (r = 0; r < cfg->roadCount; r++) {
+    if (cfg->roads[r].id == lane->road)
+      break;
+  }
+
+  for (int i = 0; i < cfg->laneCount; i++) {
+    if (strcmp(cfg->lanes[i].name, lane->name) == 0) {
+      printf("Error: Lane %s declared twice\n", lane->name);
+      return -1;
+    }
+  }
+
+  LaneConfig *lanes = (LaneConfig *)realloc(
+      cfg->lanes, sizeof(LaneConfig) * (cfg->laneCount + 1));
+  if (!lanes)
+    return -1;
+  cfg->lanes = lanes;
+
+  if (r == cfg->roadCount) {
+    RoadConfig *roads = (RoadConfig *)realloc(
+        cfg->roads, sizeof(RoadConfig) * (cfg->roadCount + 1));
+    if (!roads)
+      return -1;
+    cfg->roads = roads;
+    cfg->roads[r].id = lane->road;
+    cfg->roads[r].laneCount = 0;
+    cfg->roads[r].firstLane = cfg->laneCount;
+    cfg->roadCount++;
+  }
+
+  // Insert after the road's existing lanes and shift later roads up
+  int at = cfg->roads[r].firstLane + cfg->roads[r].laneCount;
+  memmove(&cfg->lanes[at + 1], &cfg->lanes[at],
+          sizeof(LaneConfig) * (cfg->laneCount - at));
+  cfg->lanes[at] = *lane;
+  cfg->lanes[at].roadIndex = r;
+  cfg->laneCount++;
+  cfg->roads[r].laneCount++;
+  for (int k = r + 1; k < cfg->roadCount; k++)
+    cfg->roads[k].firstLane++;
+  return 0;
+}
+
+// Number of values each lane option takes
+static int optionArity(const char *option) {
+  if (strcmp(option, "priority") == 0 || strcmp(option, "interval") == 0)
+    return 2;
+  if (strcmp(option, "poisson") == 0 || strcmp(option, "profile") == 0 ||
+      strcmp(option, "weight") == 0 || strcmp(option, "headway") == 0)
+    return 1;
+  if (strcmp(option, "platoon") == 0)
+    return 3;
+  return -1;
+}
+
+// Parses the rest of a "lane ..." line (strtok is past "lane"), returns 0 on
+// success
+static int parseLaneLine(JunctionConfig *cfg, int lineNumber) {
+  LaneConfig lane = {0};
+  lane.weight = 1;
+  lane.headway = VEHICLE_SERVICE_NS;
+  lane.arrivals.model = ARRIVAL_INTERVAL;
+  lane.arrivals.minInterval = 1;
+  lane.arrivals.maxInterval = 3;
+
+  char *word;
+  char *name = strtok(NULL, " \t");
+  if (!name || !parseLaneName(name, &lane)) {
+    printf("Error: line %d: expected 'lane <road>L<number> ...'\n",
+           lineNumber);
+    return -1;
+  }
+
+  while ((word = strtok(NULL, " \t")) != NULL) {
+    char *v[3] = {NULL, NULL, NULL};
+    int arity = optionArity(word);
+    if (arity < 0) {
+      printf("Error: line %d: unknown option '%s'\n", lineNumber, word);
+      return -1;
+    }
+    for (int k = 0; k < arity; k++) {
+      v[k] = strtok(NULL, " \t");
+      if (!v[k]) {
+        printf("Error: line %d: '%s' needs %d value%s\n", lineNumber, word,
+               arity, arity > 1 ? "s" : "");
+        return -1;
+      }
+    }
+
+    ArrivalSpec *arrivals = &lane.arrivals;
+    if (strcmp(word, "priority") == 0) {
+      lane.priorityOn = atoi(v[0]);
+      lane.priorityOff = atoi(v[1]);
+      if (lane.priorityOn <= 0 || lane.priorityOff > lane.priorityOn) {
+        printf("Error: line %d: priority needs on > 0 and off <= on\n",
+               lineNumber);
+        return -1;
+      }
+    } else if (strcmp(word, "interval") == 0) {
+      arrivals->model = ARRIVAL_INTERVAL;
+      arrivals->minInterval = atoi(v[0]);
+      arrivals->maxInterval = atoi(v[1]);
+      if (arrivals->minInterval < 1 ||
+          arrivals->maxInterval < arrivals->minInterval) {
+        printf("Error: line %d: interval needs 1 <= min <= max\n", lineNumber);
+        return -1;
+      }
+    } else if (strcmp(word, "poisson") == 0) {
+      arrivals->model = ARRIVAL_POISSON;
+      arrivals->ratePerHour = atof(v[0]);
+      if (arrivals->ratePerHour < 0) {
+        printf("Error: line %d: poisson rate must not be negative\n",
+               lineNumber);
+        return -1;
+      }
+    } else if (strcmp(word, "platoon") == 0) {
+      arrivals->model = ARRIVAL_PLATOON;
+      arrivals->ratePerHour = atof(v[0]);
+      arrivals->platoonSize = atof(v[1]);
+      arrivals->headway = (SimTime)(atof(v[2]) * NSEC_PER_SEC);
+      if (arrivals->ratePerHour < 0 || arrivals->platoonSize < 1 ||
+          arrivals->headway < 0) {
+        printf("Error: line %d: platoon needs rate >= 0, size >= 1 and "
+               "headway >= 0\n",
+               lineNumber);
+        return -1;
+      }
+    } else if (strcmp(word, "weight") == 0) {
+      lane.weight = atoi(v[0]);
+      if (lane.weight < 1) {
+        printf("Error: line %d: weight must be at least 1\n", lineNumber);
+        return -1;
+      }
+    } else if (strcmp(word, "headway") == 0) {
+      lane.headway = (SimTime)(atof(v[0]) * NSEC_PER_SEC);
+      if (lane.headway <= 0) {
+        printf("Error: line %d: headway must be positive\n", lineNumber);
+        return -1;
+      }
+    } else if (parseDemandProfile(v[0], &arrivals->profile) < 0) {
+      printf("Error: line %d: unknown profile '%s' (flat or commuter)\n",
+             lineNumber, v[0]);
+      return -1;
+    }
+  }
+
+  return addLane(cfg, &lane);
+}
+
+// Parses the rest of a "policy <name>" line, returns 0 on success
+static int parsePolicyLine(JunctionConfig *cfg, int lineNumber) {
+  char *name = strtok(NULL, " \t");
+  if (!name || strtok(NULL, " \t")) {
+    printf("Error: line %d: expected 'policy <name>'\n", lineNumber);
+    return -1;
+  }
+  if (!findSignalPolicy(name)) {
+    printf("Error: line %d: unknown signal policy '%s'\n", lineNumber, name);
+    return -1;
+  }
+  return setJunctionPolicy(cfg, name);
+}
+
+static int parseJunctionConfig(JunctionConfig *cfg, FILE *file) {
+  char line[MAX_CONFIG_LINE];
+  int lineNumber = 0;
+
+  memset(cfg, 0, sizeof(*cfg));
+  strcpy(cfg->policy, DEFAULT_SIGNAL_POLICY);
+  while (fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    line[strcspn(line, "#\r\n")] = '\0';
+    char *word = strtok(line, " \t");
+    if (!word)
+      continue;
+
+    int result;
+    if (strcmp(word, "lane") == 0) {
+      result = parseLaneLine(cfg, lineNumber);
+    } else if (strcmp(word, "policy") == 0) {
+      result = parsePolicyLine(cfg, lineNumber);
+    } else {
+      printf("Error: line %d: expected 'lane <road>L<number> ...' or "
+             "'policy <name>'\n",
+             lineNumber);
+      result = -1;
+    }
+    if (result < 0) {
+      freeJunctionConfig(cfg);
+      return -1;
+    }
+  }
+
+  if (cfg->laneCount == 0) {
+    printf("Error: Junction has no lanes\n");
+    return -1;
+  }
+  return 0;
+}
+
+int loadDefaultJunctionConfig(JunctionConfig *cfg) {
+  FILE *file =
+      fmemopen((void *)DEFAULT_JUNCTION, strlen(DEFAULT_JUNCTION), "r");
+  if (!file)
+    return -1;
+  int result = parseJunctionConfig(cfg, file);
+  fclose(file);
+  return result;
+}
+
+int loadJunctionConfig(JunctionConfig *cfg, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror("Error opening junction config");
+    return -1;
+  }
+  int result = parseJunctionConfig(cfg, file);
+  fclose(file);
+  return result;
+}
+
+int copyJunctionConfig(JunctionConfig *dst, const JunctionConfig *src) {
+  memset(dst, 0, sizeof(*dst));
+  dst->roads = (RoadConfig *)malloc(sizeof(RoadConfig) * src->roadCount);
+  dst->lanes = (LaneConfig *)malloc(sizeof(LaneConfig) * src->laneCount);
+  if (!dst->roads || !dst->lanes) {
+    freeJunctionConfig(dst);
+    return -1;
+  }
+  memcpy(dst->roads, src->roads, sizeof(RoadConfig) * src->roadCount);
+  memcpy(dst->lanes, src->lanes, sizeof(LaneConfig) * src->laneCount);
+  dst->roadCount = src->roadCount;
+  dst->laneCount = src->laneCount;
+  strcpy(dst->policy, src->policy);
+  return 0;
+}
+
+int setJunctionPolicy(JunctionConfig *cfg, const char *name) {
+  if (!findSignalPolicy(name)) {
+    printf("Error: Unknown signal policy '%s' (", name);
+    for (int i = 0; i < SIGNAL_POLICY_COUNT; i++)
+      printf("%s%s", i > 0 ? ", " : "", SIGNAL_POLICIES[i].name);
+    printf(")\n");
+    return -1;
+  }
+  // Aliases are stored under the policy's full name
+  snprintf(cfg->policy, sizeof(cfg->policy), "%s",
+           findSignalPolicy(name)->name);
+  return 0;
+}
+
+void freeJunctionConfig(JunctionConfig *cfg) {
+  free(cfg->roads);
+  free(cfg->lanes);
+  memset(cfg, 0, sizeof(*cfg));
+}
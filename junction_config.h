@@ -0,0 +1,59 @@
+#ifndef JUNCTION_CONFIG_H
+#define JUNCTION_CONFIG_H
+
+#include <stdbool.h>
+
+#include "arrivals.h"
+
+#define MAX_LANE_NAME 8
+#define MAX_POLICY_NAME 32
+
+// One queued approach lane, named like the README: road letter + "L" + lane
+// number, e.g. AL2
+typedef struct {
+  char name[MAX_LANE_NAME];
+  char road;       // 'A'..'Z'
+  int laneNumber;  // lane number on the road
+  int roadIndex;   // index into JunctionConfig.roads
+  int priorityOn;  // priority when count > priorityOn, 0 = normal lane
+  int priorityOff; // back to normal when count < priorityOff
+  int weight;      // share of the green under the weighted policy, >= 1
+  SimTime headway; // saturation headway: green time per departing vehicle
+  ArrivalSpec arrivals; // how simulated arrivals are generated
+} LaneConfig;
+
+// A road is one signal phase: all of its lanes get green together
+typedef struct {
+  char id;
+  int laneCount;
+  int firstLane; // lanes of a road are contiguous in JunctionConfig.lanes
+} RoadConfig;
+
+typedef struct {
+  int roadCount;
+  RoadConfig *roads;
+  int laneCount;
+  LaneConfig *lanes;
+  char policy[MAX_POLICY_NAME]; // signal policy, see signal_control.h
+} JunctionConfig;
+
+// The classic 4-arm junction: AL2 (priority 7/4), BL2, CL3, DL4
+int loadDefaultJunctionConfig(JunctionConfig *cfg);
+
+// Reads a junction description. Each non-comment line declares a lane:
+//   lane <name> [priority <on> <off>] [interval <min> <max>]
+//               [poisson <veh/h>] [platoon <veh/h> <size> <headway>]
+//               [profile flat|commuter] [weight <n>] [headway <s>]
+// or the signal policy (default "priority"):
+//   policy <name>
+// Returns 0 on success, -1 on error (message printed)
+int loadJunctionConfig(JunctionConfig *cfg, const char *path);
+
+// Selects the signal policy by name. Returns -1 (message printed) if there
+// is no such policy
+int setJunctionPolicy(JunctionConfig *cfg, const char *name);
+
+int copyJunctionConfig(JunctionConfig *dst, const JunctionConfig *src);
+void freeJunctionConfig(JunctionConfig *cfg);
+
+#endif
@@ -0,0 +1,101 @@
+#include "junction_snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+JunctionSnapshot *createSnapshot(int laneCount) {
+  JunctionSnapshot *s =
+      (JunctionSnapshot *)calloc(1, sizeof(JunctionSnapshot));
+  if (!s) {
+    printf("Error: Failed to allocate memory for snapshot\n");
+    return NULL;
+  }
+  s->counts = (_Atomic int *)calloc(laneCount, sizeof(_Atomic int));
+  s->served = (_Atomic long *)calloc(laneCount, sizeof(_Atomic long));
+  if (!s->counts || !s->served) {
+    printf("Error: Failed to allocate memory for snapshot\n");
+    freeSnapshot(s);
+    return NULL;
+  }
+  s->laneCount = laneCount;
+  return s;
+}
+
+void freeSnapshot(JunctionSnapshot *s) {
+  if (!s)
+    return;
+  free(s->counts);
+  free(s->served);
+  free(s);
+}
+
+// The publisher is the only writer, so it can compare against the published
+// values with plain relaxed loads
+static bool snapshotChanged(const JunctionSnapshot *s, const Junction *j,
+                            int light) {
+  if (atomic_load_explicit(&s->light, memory_order_relaxed) != light)
+    return true;
+  for (int i = 0; i < s->laneCount; i++) {
+    if (atomic_load_explicit(&s->counts[i], memory_order_relaxed) !=
+            getSize(j->lanes[i].queue) ||
+        atomic_load_explicit(&s->served[i], memory_order_relaxed) !=
+            j->lanes[i].served)
+      return true;
+  }
+  return false;
+}
+
+void publishSnapshot(JunctionSnapshot *s, const Junction *j, int light) {
+  unsigned long seq = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+  if (seq != 0 && !snapshotChanged(s, j, light))
+    return;
+
+  // Odd sequence first, then the data, then the next even sequence
+  atomic_store_explicit(&s->sequence, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&s->light, light, memory_order_relaxed);
+  for (int i = 0; i < s->laneCount; i++) {
+    atomic_store_explicit(&s->counts[i], getSize(j->lanes[i].queue),
+                          memory_order_relaxed);
+    atomic_store_explicit(&s->served[i], j->lanes[i].served,
+                          memory_order_relaxed);
+  }
+  atomic_store_explicit(&s->sequence, seq + 2, memory_order_release);
+}
+
+int initSnapshotFrame(SnapshotFrame *f, int laneCount) {
+  f->sequence = 0;
+  f->laneCount = laneCount;
+  f->light = 0;
+  f->counts = (int *)calloc(laneCount, sizeof(int));
+  f->served = (long *)calloc(laneCount, sizeof(long));
+  if (!f->counts || !f->served) {
+    freeSnapshotFrame(f);
+    return -1;
+  }
+  return 0;
+}
+
+void freeSnapshotFrame(SnapshotFrame *f) {
+  free(f->counts);
+  free(f->served);
+  f->counts = NULL;
+  f->served = NULL;
+}
+
+void readSnapshot(const JunctionSnapshot *s, SnapshotFrame *f) {
+  unsigned long before, after = 0;
+  do {
+    before = atomic_load_explicit(&s->sequence, memory_order_acquire);
+    if (before & 1)
+      continue;
+    f->light = atomic_load_explicit(&s->light, memory_order_relaxed);
+    for (int i = 0; i < f->laneCount && i < s->laneCount; i++) {
+      f->counts[i] = atomic_load_explicit(&s->counts[i], memory_order_relaxed);
+      f->served[i] = atomic_load_explicit(&s->served[i], memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    after = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+  } while ((before & 1) || before != after);
+  f->sequence = before;
+}
@@ -0,0 +1,49 @@
+#ifndef JUNCTION_SNAPSHOT_H
+#define JUNCTION_SNAPSHOT_H
+
+#include <stdatomic.h>
+
+#include "junction.h"
+
+#define SNAPSHOT_INTERVAL_NS 16000000LL // publish period, about 60 per s
+
+// State of a junction as one consistent picture: the lane counts, vehicles
+// served so far and the light at the same instant. One thread (the
+// controller) publishes, any thread reads without locks under a sequence
+// lock: the sequence is odd while a publish is in progress and readers retry
+// if it moved under them. Fields are relaxed atomics so a torn read is
+// retried, never undefined
+typedef struct {
+  _Atomic unsigned long sequence;
+  int laneCount;
+  _Atomic int light; // 0 = all red, n = road n-1 green
+  _Atomic int *counts;  // laneCount entries
+  _Atomic long *served; // laneCount entries
+} JunctionSnapshot;
+
+// A reader's copy. 'counts' and 'served' are owned by the frame
+typedef struct {
+  unsigned long sequence; // changes with every publish that changed anything
+  int laneCount;
+  int light;
+  int *counts;
+  long *served;
+} SnapshotFrame;
+
+JunctionSnapshot *createSnapshot(int laneCount);
+void freeSnapshot(JunctionSnapshot *s);
+
+// Publishes the junction's current lanes with 'light'. Skipped if
+// nothing changed, so an unchanged sequence means an unchanged picture.
+// Publishing thread only
+void publishSnapshot(JunctionSnapshot *s, const Junction *j, int light);
+
+// Frames for a snapshot of laneCount lanes. Returns -1 if out of memory
+int initSnapshotFrame(SnapshotFrame *f, int laneCount);
+void freeSnapshotFrame(SnapshotFrame *f);
+
+// Copies the latest published picture into f, retrying while a publish is
+// in progress. Never blocks the publisher
+void readSnapshot(const JunctionSnapshot *s, SnapshotFrame *f);
+
+#endif
@@ -0,0 +1,119 @@
+#include "latency.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+void initLatencyHistogram(LatencyHistogram *h) {
+  memset(h, 0, sizeof(*h));
+}
+
+// Values below 2^SUB_BITS get a bucket each; above, the top SUB_BITS + 1 bits
+// select the bucket within the value's power of two
+static int bucketIndex(SimTime ns) {
+  if (ns < (1 << LATENCY_SUB_BITS))
+    return (int)ns;
+  int msb = 63 - __builtin_clzll((unsigned long long)ns);
+  if (msb >= LATENCY_MAX_BITS)
+    return LATENCY_BUCKETS - 1;
+  int shift = msb - LATENCY_SUB_BITS;
+  return ((shift + 1) << LATENCY_SUB_BITS) +
+         (int)((ns >> shift) - (1 << LATENCY_SUB_BITS));
+}
+
+// Largest value that falls into bucket i
+static SimTime bucketTop(int i) {
+  if (i < (1 << LATENCY_SUB_BITS))
+    return i;
+  int shift = (i >> LATENCY_SUB_BITS) - 1;
+  SimTime base = (SimTime)((i & ((1 << LATENCY_SUB_BITS) - 1)) +
+                           (1 << LATENCY_SUB_BITS))
+                 << shift;
+  return base + ((SimTime)1 << shift) - 1;
+}
+
+// Single writer, so a relaxed load and store is enough for each counter and
+// compiles to plain moves
+#define BUMP(field, delta)                                                     \
+  atomic_store_explicit(                                                       \
+      &(field), atomic_load_explicit(&(field), memory_order_relaxed) + (delta), \
+      memory_order_relaxed)
+
+void recordLatency(LatencyHistogram *h, SimTime ns) {
+  if (ns < 0)
+    ns = 0;
+  BUMP(h->counts[bucketIndex(ns)], 1);
+  BUMP(h->total, ns);
+  if (ns > atomic_load_explicit(&h->max, memory_order_relaxed))
+    atomic_store_explicit(&h->max, ns, memory_order_relaxed);
+  BUMP(h->count, 1);
+}
+
+void mergeLatency(LatencyHistogram *dst, const LatencyHistogram *src) {
+  for (int i = 0; i < LATENCY_BUCKETS; i++)
+    BUMP(dst->counts[i], atomic_load_explicit(&src->counts[i],
+                                              memory_order_relaxed));
+  BUMP(dst->total, atomic_load_explicit(&src->total, memory_order_relaxed));
+  SimTime max = atomic_load_explicit(&src->max, memory_order_relaxed);
+  if (max > atomic_load_explicit(&dst->max, memory_order_relaxed))
+    atomic_store_explicit(&dst->max, max, memory_order_relaxed);
+  BUMP(dst->count, atomic_load_explicit(&src->count, memory_order_relaxed));
+}
+
+SimTime latencyPercentile(const LatencyHistogram *h, double percentile) {
+  long count = atomic_load_explicit(&h->count, memory_order_relaxed);
+  SimTime max = atomic_load_explicit(&h->max, memory_order_relaxed);
+  if (count == 0)
+    return 0;
+
+  // Rank of the wanted recording, 1-based
+  long rank = (long)(percentile / 100.0 * count + 0.999999);
+  if (rank < 1)
+    rank = 1;
+
+  long seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+    if (seen >= rank) {
+      SimTime top = bucketTop(i);
+      return top < max ? top : max;
+    }
+  }
+  return max;
+}
+
+LatencySummary getLatencySummary(const LatencyHistogram *h) {
+  LatencySummary s;
+  s.count = atomic_load_explicit(&h->count, memory_order_relaxed);
+  s.mean = s.count > 0
+               ? atomic_load_explicit(&h->total, memory_order_relaxed) / s.count
+               : 0;
+  s.p50 = latencyPercentile(h, 50);
+  s.p95 = latencyPercentile(h, 95);
+  s.p99 = latencyPercentile(h, 99);
+  s.max = atomic_load_explicit(&h->max, memory_order_relaxed);
+  return s;
+}
+
+void printLatencyColumns(FILE *out, const LatencySummary *s) {
+  fprintf(out, " %7.1f %7.1f %7.1f %7.1f %7.1f",
+          (double)s->mean / NSEC_PER_SEC, (double)s->p50 / NSEC_PER_SEC,
+          (double)s->p95 / NSEC_PER_SEC, (double)s->p99 / NSEC_PER_SEC,
+          (double)s->max / NSEC_PER_SEC);
+}
+
+void printLatencyLine(FILE *out, const char *label, const LatencySummary *s) {
+  bool ms = s->max < NSEC_PER_SEC;
+  double unit = ms ? 1e6 : NSEC_PER_SEC;
+  const char *format = ms ? "%s: mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  "
+                            "max %.3f ms"
+                          : "%s: mean %.1f  p50 %.1f  p95 %.1f  p99 %.1f  "
+                            "max %.1f s";
+  fprintf(out, format, label, s->mean / unit, s->p50 / unit, s->p95 / unit,
+          s->p99 / unit, s->max / unit);
+}
+
+void writeLatencyCsv(FILE *out, const LatencySummary *s) {
+  fprintf(out, "%.3f,%.3f,%.3f,%.3f,%.3f", (double)s->mean / NSEC_PER_SEC,
+          (double)s->p50 / NSEC_PER_SEC, (double)s->p95 / NSEC_PER_SEC,
+          (double)s->p99 / NSEC_PER_SEC, (double)s->max / NSEC_PER_SEC);
+}
@@ -0,0 +1,64 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim_time.h"
+
+// Log-linear buckets in the style of HdrHistogram: every power of two is
+// split into 2^LATENCY_SUB_BITS buckets, so a recorded value is off by at most
+// 1/32 (about 3%) however large it is. Values from 2^LATENCY_MAX_BITS ns
+// (about 39 h) up land in the last bucket; the exact maximum is kept apart
+#define LATENCY_SUB_BITS 5
+#define LATENCY_MAX_BITS 47
+#define LATENCY_BUCKETS                                                        \
+  ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+// Distribution of one lane's waits in ns. Written by one thread (the
+// controller) and readable from any thread at any time, like the pool
+// counters: stores are relaxed atomics, so a reader may see a recording half
+// done but never a torn counter
+typedef struct {
+  _Atomic uint32_t counts[LATENCY_BUCKETS];
+  _Atomic long count;
+  _Atomic SimTime total;
+  _Atomic SimTime max;
+} LatencyHistogram;
+
+// Snapshot of a histogram, all times in ns
+typedef struct {
+  long count;
+  SimTime mean;
+  SimTime p50;
+  SimTime p95;
+  SimTime p99;
+  SimTime max;
+} LatencySummary;
+
+void initLatencyHistogram(LatencyHistogram *h);
+void recordLatency(LatencyHistogram *h, SimTime ns); // writer thread only
+
+// Value at or below which 'percentile' (0-100) of the recordings lie,
+// rounded up to the top of its bucket and never above the maximum
+SimTime latencyPercentile(const LatencyHistogram *h, double percentile);
+LatencySummary getLatencySummary(const LatencyHistogram *h);
+
+// Adds the recordings of 'src' to 'dst', e.g. to combine lanes. 'dst' must
+// not be shared with another thread
+void mergeLatency(LatencyHistogram *dst, const LatencyHistogram *src);
+
+// Table columns in seconds: mean p50 p95 p99 max
+void printLatencyColumns(FILE *out, const LatencySummary *s);
+
+// "label: mean 1.2  p50 1.0  p95 3.4  p99 5.6  max 7.8 s" without a line
+// break, in ms when every value is below a second
+void printLatencyLine(FILE *out, const char *label, const LatencySummary *s);
+
+// The same values as CSV fields, without a line break
+#define LATENCY_CSV_HEADER                                                     \
+  "wait_mean_s,wait_p50_s,wait_p95_s,wait_p99_s,wait_max_s"
+void writeLatencyCsv(FILE *out, const LatencySummary *s);
+
+#endif
@@ -0,0 +1,664 @@
+#include "network.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_NETWORK_LINE 512
+
+// Adds a junction with no links yet, returns its index or -1
+static int addNode(Network *n, const char *name, const JunctionConfig *cfg) {
+  if (strlen(name) >= MAX_NODE_NAME) {
+    printf("Error: Junction name '%s' is too long\n", name);
+    return -1;
+  }
+  for (int i = 0; i < n->nodeCount; i++) {
+    if (strcmp(n->nodes[i].name, name) == 0) {
+      printf("Error: Junction %s declared twice\n", name);
+      return -1;
+    }
+  }
+
+  NetworkNode *nodes = (NetworkNode *)realloc(
+      n->nodes, sizeof(NetworkNode) * (n->nodeCount + 1));
+  if (!nodes) {
+    printf("Error: Failed to allocate memory for network\n");
+    return -1;
+  }
+  n->nodes = nodes;
+
+  NetworkNode *node = &n->nodes[n->nodeCount];
+  memset(node, 0, sizeof(*node));
+  strcpy(node->name, name);
+  node->junction = createJunction(cfg);
+  node->exits = (NetworkLink *)malloc(sizeof(NetworkLink) * cfg->roadCount);
+  node->fed = (bool *)calloc(cfg->roadCount, sizeof(bool));
+  node->arrivals =
+      (ArrivalStream *)malloc(sizeof(ArrivalStream) * cfg->laneCount);
+  if (!node->junction || !node->exits || !node->fed || !node->arrivals) {
+    freeJunction(node->junction);
+    free(node->exits);
+    free(node->fed);
+    free(node->arrivals);
+    return -1;
+  }
+  for (int r = 0; r < cfg->roadCount; r++)
+    node->exits[r] = (NetworkLink){-1, 0, 0};
+
+  return n->nodeCount++;
+}
+
+static int findNode(const Network *n, const char *name) {
+  for (int i = 0; i < n->nodeCount; i++) {
+    if (strcmp(n->nodes[i].name, name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+// Sends vehicles served on 'fromRoad' of 'from' to 'toRoad' of 'to'
+static int addLink(Network *n, int from, char fromRoad, int to, char toRoad,
+                   SimTime travel) {
+  NetworkNode *src = &n->nodes[from];
+  NetworkNode *dst = &n->nodes[to];
+  int exitRoad = roadIndex(src->junction, fromRoad);
+  int entryRoad = roadIndex(dst->junction, toRoad);
+
+  if (exitRoad < 0 || entryRoad < 0) {
+    printf("Error: Link %s:%c -> %s:%c uses an unknown road\n", src->name,
+           fromRoad, dst->name, toRoad);
+    return -1;
+  }
+  if (src->exits[exitRoad].junction >= 0) {
+    printf("Error: Road %c of %s already has a link\n", fromRoad, src->name);
+    return -1;
+  }
+
+  src->exits[exitRoad] = (NetworkLink){to, toRoad, travel};
+  dst->fed[entryRoad] = true;
+  return 0;
+}
+
+// Parses one "junction ..." or "link ..." line, returns 0 on success
+static int parseNetworkLine(Network *n, char *line, int lineNumber) {
+  char *word = strtok(line, " \t");
+
+  if (strcmp(word, "junction") == 0) {
+    char *name = strtok(NULL, " \t");
+    char *configPath = strtok(NULL, " \t");
+    JunctionConfig cfg;
+    if (!name) {
+      printf("Error: line %d: expected 'junction <name> [config]'\n",
+             lineNumber);
+      return -1;
+    }
+    int loaded = configPath ? loadJunctionConfig(&cfg, configPath)
+                            : loadDefaultJunctionConfig(&cfg);
+    if (loaded < 0)
+      return -1;
+    int index = addNode(n, name, &cfg);
+    freeJunctionConfig(&cfg);
+    return index < 0 ? -1 : 0;
+  }
+
+  if (strcmp(word, "link") == 0) {
+    char *from = strtok(NULL, " \t");
+    char *fromRoad = strtok(NULL, " \t");
+    char *to = strtok(NULL, " \t");
+    char *toRoad = strtok(NULL, " \t");
+    char *travel = strtok(NULL, " \t");
+    if (!from || !fromRoad || !to || !toRoad || !travel) {
+      printf("Error: line %d: expected 'link <from> <road> <to> <road> "
+             "<seconds>'\n",
+             lineNumber);
+      return -1;
+    }
+    int src = findNode(n, from);
+    int dst = findNode(n, to);
+    if (src < 0 || dst < 0) {
+      printf("Error: line %d: junctions must be declared before their "
+             "links\n",
+             lineNumber);
+      return -1;
+    }
+    double seconds = atof(travel);
+    if (seconds < 0) {
+      printf("Error: line %d: travel time must not be negative\n",
+             lineNumber);
+      return -1;
+    }
+    return addLink(n, src, fromRoad[0], dst, toRoad[0],
+                   (SimTime)(seconds * NSEC_PER_SEC));
+  }
+
+  printf("Error: line %d: unknown statement '%s'\n", lineNumber, word);
+  return -1;
+}
+
+Network *loadNetwork(const char *path) {
+  char line[MAX_NETWORK_LINE];
+  int lineNumber = 0;
+
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror("Error opening network file");
+    return NULL;
+  }
+
+  Network *n = (Network *)calloc(1, sizeof(Network));
+  if (!n) {
+    printf("Error: Failed to allocate memory for network\n");
+    fclose(file);
+    return NULL;
+  }
+
+  while (fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    line[strcspn(line, "#\r\n")] = '\0';
+    if (strspn(line, " \t") == strlen(line))
+      continue;
+    if (parseNetworkLine(n, line, lineNumber) < 0) {
+      fclose(file);
+      freeNetwork(n);
+      return NULL;
+    }
+  }
+  fclose(file);
+
+  if (n->nodeCount == 0) {
+    printf("Error: Network has no junctions\n");
+    freeNetwork(n);
+    return NULL;
+  }
+  return n;
+}
+
+Network *createGridNetwork(int width, int height, const JunctionConfig *cfg,
+                           SimTime travel) {
+  char name[32];
+
+  if (width < 1 || height < 1) {
+    printf("Error: Grid needs at least one junction\n");
+    return NULL;
+  }
+
+  Network *n = (Network *)calloc(1, sizeof(Network));
+  if (!n) {
+    printf("Error: Failed to allocate memory for network\n");
+    return NULL;
+  }
+
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      snprintf(name, sizeof(name), "J%d_%d", x, y);
+      if (addNode(n, name, cfg) < 0) {
+        freeNetwork(n);
+        return NULL;
+      }
+    }
+  }
+
+  // Straight-through links, skipping arms the junction layout doesn't have
+  const Junction *layout = n->nodes[0].junction;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int here = y * width + x;
+      struct {
+        char road;
+        int dx, dy;
+      } moves[] = {{'A', 0, 1}, {'B', 0, -1}, {'C', -1, 0}, {'D', 1, 0}};
+
+      for (int m = 0; m < 4; m++) {
+        int tx = x + moves[m].dx;
+        int ty = y + moves[m].dy;
+        if (tx < 0 || tx >= width || ty < 0 || ty >= height ||
+            roadIndex(layout, moves[m].road) < 0)
+          continue;
+        addLink(n, here, moves[m].road, ty * width + tx, moves[m].road,
+                travel);
+      }
+    }
+  }
+
+  return n;
+}
+
+void freeNetwork(Network *n) {
+  if (!n)
+    return;
+  for (int i = 0; i < n->nodeCount; i++) {
+    freeJunction(n->nodes[i].junction);
+    free(n->nodes[i].exits);
+    free(n->nodes[i].fed);
+    free(n->nodes[i].arrivals);
+  }
+  free(n->nodes);
+  free(n);
+}
+
+// Vehicles crossing to another partition, collected during a window and
+// delivered by the receiving thread after it
+typedef struct {
+  Event event;
+  Vehicle vehicle;
+} Transfer;
+
+typedef struct {
+  Transfer *items;
+  int count;
+  int capacity;
+} TransferBuffer;
+
+struct NetworkPartition {
+  Network *network;
+  int index;
+  EventHeap *heap;
+  SimTime now;
+  SimTime nextEvent;      // earliest pending event, published between windows
+  TransferBuffer *outbox; // one per destination partition
+  NetworkStats stats;
+};
+
+// Schedules an event on behalf of 'from', keyed by that junction's own
+// sequence so the order is the same however the network is partitioned
+static void scheduleEvent(NetworkPartition *p, NetworkNode *from, SimTime time,
+                          EventType type, int junction, int lane,
+                          VehicleId v) {
+  int source = (int)(from - p->network->nodes);
+  Event e = {time, from->nextSeq++, source, type, junction, lane, v};
+  insertEvent(p->heap, &e);
+}
+
+// Keeps one pending arrival per generated lane on the heap
+static void scheduleArrival(NetworkPartition *p, NetworkNode *node,
+                            int junction, int lane) {
+  SimTime t = nextArrival(&node->arrivals[lane]);
+  if (t != INT64_MAX)
+    scheduleEvent(p, node, t, EVENT_ARRIVAL, junction, lane, NO_VEHICLE);
+}
+
+// Moves a vehicle into the downstream junction's pool and queues its arrival
+// there. Runs on the thread that owns the downstream junction
+static void deliverTransfer(NetworkPartition *p, Event *e, const Vehicle *v) {
+  Junction *j = p->network->nodes[e->junction].junction;
+  const LaneConfig *lane = &j->config.lanes[e->lane];
+
+  VehicleId moved = poolAlloc(j->pool);
+  if (moved == NO_VEHICLE) {
+    j->lanes[e->lane].dropped++;
+    return;
+  }
+  storeVehicle(j->pool, moved, v);
+  VEHICLE_FIELD(j->pool, moved, road) = lane->road;
+  VEHICLE_FIELD(j->pool, moved, lane) = (unsigned char)lane->laneNumber;
+  e->vehicle = moved;
+  insertEvent(p->heap, e);
+}
+
+static int appendTransfer(TransferBuffer *buf, const Event *e,
+                          const Vehicle *v) {
+  if (buf->count == buf->capacity) {
+    int newCapacity = buf->capacity ? buf->capacity * 2 : 64;
+    Transfer *grown =
+        (Transfer *)realloc(buf->items, sizeof(Transfer) * newCapacity);
+    if (!grown) {
+      printf("Error: Failed to grow transfer buffer\n");
+      return -1;
+    }
+    buf->items = grown;
+    buf->capacity = newCapacity;
+  }
+  buf->items[buf->count].event = *e;
+  buf->items[buf->count].vehicle = *v;
+  buf->count++;
+  return 0;
+}
+
+// Departure hook: hands a served vehicle to the next junction on its road, or
+// lets it leave the network
+static void departVehicle(Junction *j, int lane, VehicleId id, void *ctx) {
+  NetworkNode *node = (NetworkNode *)ctx;
+  Network *n = node->network;
+  NetworkPartition *p = &n->partitions[node->partition];
+  const NetworkLink *link = &node->exits[j->config.lanes[lane].roadIndex];
+
+  if (link->junction < 0) {
+    p->stats.exited++;
+    p->stats.journeyTime += p->now - VEHICLE_FIELD(j->pool, id, generatedAt);
+    poolFree(j->pool, id);
+    return;
+  }
+
+  // Copied out, the downstream junction has its own pool
+  Vehicle v;
+  loadVehicle(j->pool, id, &v);
+
+  // Keep the lane number if the downstream road has it, else its first lane
+  NetworkNode *dest = &n->nodes[link->junction];
+  int nextLane = findLane(dest->junction, link->road, v.lane);
+  if (nextLane < 0)
+    nextLane = findLane(dest->junction, link->road, 0);
+
+  int source = (int)(node - n->nodes);
+  Event e = {p->now + link->travel, node->nextSeq++, source, EVENT_TRANSFER,
+             link->junction,        nextLane,        NO_VEHICLE};
+  p->stats.transfers++;
+
+  // The vehicle moves into the downstream junction's pool, which owns it
+  // from now on. Only that junction's thread may allocate from it
+  if (dest->partition == node->partition)
+    deliverTransfer(p, &e, &v);
+  else if (appendTransfer(&p->outbox[dest->partition], &e, &v) < 0)
+    dest->junction->lanes[nextLane].dropped++;
+  poolFree(j->pool, id);
+}
+
+static void handleEvent(NetworkPartition *p, const Event *e) {
+  NetworkNode *node = &p->network->nodes[e->junction];
+  Junction *j = node->junction;
+
+  p->stats.events++;
+  p->stats.simulated = p->now = j->now = e->time;
+
+  if (e->type == EVENT_ARRIVAL) {
+    const LaneConfig *lane = &j->config.lanes[e->lane];
+    VehicleId v = poolAlloc(j->pool);
+    if (v != NO_VEHICLE) {
+      generateVehicleNumber(VEHICLE_FIELD(j->pool, v, vehicleNumber),
+                            &node->rng);
+      VEHICLE_FIELD(j->pool, v, road) = lane->road;
+      VEHICLE_FIELD(j->pool, v, lane) = (unsigned char)lane->laneNumber;
+      VEHICLE_FIELD(j->pool, v, generatedAt) = e->time;
+      VEHICLE_FIELD(j->pool, v, ingestedAt) = e->time;
+      if (junctionEnqueue(j, v) == 0)
+        p->stats.entered++;
+      else
+        poolFree(j->pool, v);
+    }
+    scheduleArrival(p, node, e->junction, e->lane);
+  } else if (e->type == EVENT_TRANSFER) {
+    if (junctionEnqueue(j, e->vehicle) < 0)
+      poolFree(j->pool, e->vehicle);
+  } else {
+    SimTime delay = controllerStep(&node->controller, &node->signals, j);
+    scheduleEvent(p, node, e->time + delay, EVENT_CONTROLLER, e->junction, -1,
+                  NO_VEHICLE);
+  }
+}
+
+static SimTime nextEventTime(const NetworkPartition *p) {
+  return p->heap->size > 0 ? p->heap->events[0].time : INT64_MAX;
+}
+
+// Worker loop. Every window starts at the earliest pending event of the whole
+// network and is one lookahead long: a vehicle leaving during the window can
+// only reach another partition after it, so each partition runs its window
+// alone and the crossing vehicles are handed over at the barrier
+static void *runPartition(void *arg) {
+  NetworkPartition *p = (NetworkPartition *)arg;
+  Network *n = p->network;
+  Event e;
+
+  for (;;) {
+    SimTime windowStart = INT64_MAX;
+    for (int q = 0; q < n->partitionCount; q++) {
+      if (n->partitions[q].nextEvent < windowStart)
+        windowStart = n->partitions[q].nextEvent;
+    }
+    if (windowStart > n->duration)
+      break;
+    SimTime windowEnd = n->lookahead > n->duration - windowStart
+                            ? n->duration + 1
+                            : windowStart + n->lookahead;
+
+    while (nextEventTime(p) < windowEnd) {
+      popEvent(p->heap, &e);
+      handleEvent(p, &e);
+    }
+    pthread_barrier_wait(&n->barrier);
+
+    // Take over the vehicles other partitions sent here
+    for (int q = 0; q < n->partitionCount; q++) {
+      TransferBuffer *inbox = &n->partitions[q].outbox[p->index];
+      for (int i = 0; i < inbox->count; i++)
+        deliverTransfer(p, &inbox->items[i].event, &inbox->items[i].vehicle);
+      inbox->count = 0;
+    }
+    p->nextEvent = nextEventTime(p);
+    pthread_barrier_wait(&n->barrier);
+  }
+
+  return NULL;
+}
+
+// Splits the junctions into contiguous blocks (strips of a row-major grid)
+// and finds the shortest link between two blocks. Falls back to fewer
+// partitions while zero-length links cross a boundary
+static void partitionNetwork(Network *n, int threads) {
+  if (threads > n->nodeCount)
+    threads = n->nodeCount;
+  if (threads < 1)
+    threads = 1;
+  int requested = threads;
+
+  for (;;) {
+    n->partitionCount = threads;
+    n->lookahead = INT64_MAX;
+    for (int i = 0; i < n->nodeCount; i++)
+      n->nodes[i].partition = (int)((long)i * threads / n->nodeCount);
+
+    for (int i = 0; i < n->nodeCount; i++) {
+      const NetworkNode *node = &n->nodes[i];
+      for (int r = 0; r < node->junction->config.roadCount; r++) {
+        const NetworkLink *link = &node->exits[r];
+        if (link->junction >= 0 &&
+            n->nodes[link->junction].partition != node->partition &&
+            link->travel < n->lookahead)
+          n->lookahead = link->travel;
+      }
+    }
+
+    if (n->lookahead > 0 || threads == 1)
+      break;
+    threads /= 2;
+  }
+
+  if (threads < requested) {
+    printf("Warning: Zero travel time between partitions, using %d of %d "
+           "threads\n",
+           threads, requested);
+  }
+}
+
+int runNetworkSimulation(Network *n, const SimConfig *cfg, int threads,
+                         NetworkStats *stats) {
+  if (cfg->duration <= 0) {
+    printf("Error: Network simulation needs a duration\n");
+    return -1;
+  }
+
+  partitionNetwork(n, threads);
+  n->duration = cfg->duration;
+  n->partitions = (NetworkPartition *)calloc(n->partitionCount,
+                                             sizeof(NetworkPartition));
+  if (!n->partitions) {
+    printf("Error: Failed to allocate memory for network partitions\n");
+    return -1;
+  }
+
+  int result = 0;
+  for (int q = 0; q < n->partitionCount; q++) {
+    NetworkPartition *p = &n->partitions[q];
+    p->network = n;
+    p->index = q;
+    p->heap = createEventHeap();
+    p->outbox =
+        (TransferBuffer *)calloc(n->partitionCount, sizeof(TransferBuffer));
+    if (!p->heap || !p->outbox)
+      result = -1;
+  }
+
+  for (int i = 0; result == 0 && i < n->nodeCount; i++) {
+    NetworkNode *node = &n->nodes[i];
+    NetworkPartition *p = &n->partitions[node->partition];
+    Junction *j = node->junction;
+
+    node->network = n;
+    node->signals = (SharedData){0, false, j, NULL};
+    rngSeed(&node->rng, cfg->seed, (uint64_t)i);
+    node->nextSeq = 0;
+    initController(&node->controller, j, false);
+    j->priority->logChanges = false;
+    j->simulated = true;
+    j->onDeparture = departVehicle;
+    j->departureCtx = node;
+
+    // Generated arrivals only where no upstream junction feeds the road
+    for (int l = 0; l < j->config.laneCount; l++) {
+      if (!node->fed[j->config.lanes[l].roadIndex]) {
+        initArrivalStream(&node->arrivals[l], &j->config.lanes[l].arrivals,
+                          &node->rng, 0);
+        scheduleArrival(p, node, i, l);
+      }
+    }
+    scheduleEvent(p, node, 0, EVENT_CONTROLLER, i, -1, NO_VEHICLE);
+  }
+
+  SimTime wallStart = monotonicNs();
+
+  if (result == 0) {
+    for (int q = 0; q < n->partitionCount; q++)
+      n->partitions[q].nextEvent = nextEventTime(&n->partitions[q]);
+
+    pthread_barrier_init(&n->barrier, NULL, n->partitionCount);
+    pthread_t *workers =
+        (pthread_t *)malloc(sizeof(pthread_t) * n->partitionCount);
+    if (workers) {
+      for (int q = 1; q < n->partitionCount; q++)
+        pthread_create(&workers[q], NULL, runPartition, &n->partitions[q]);
+      runPartition(&n->partitions[0]);
+      for (int q = 1; q < n->partitionCount; q++)
+        pthread_join(workers[q], NULL);
+      free(workers);
+    } else {
+      result = -1;
+    }
+    pthread_barrier_destroy(&n->barrier);
+  }
+
+  memset(stats, 0, sizeof(*stats));
+  stats->wallSeconds = (double)(monotonicNs() - wallStart) / NSEC_PER_SEC;
+  for (int q = 0; q < n->partitionCount; q++) {
+    NetworkPartition *p = &n->partitions[q];
+    const NetworkStats *s = &p->stats;
+
+    if (s->simulated > stats->simulated)
+      stats->simulated = s->simulated;
+    stats->events += s->events;
+    stats->entered += s->entered;
+    stats->transfers += s->transfers;
+    stats->exited += s->exited;
+    stats->journeyTime += s->journeyTime;
+    for (int i = 0; p->heap && i < p->heap->size; i++) {
+      if (p->heap->events[i].type == EVENT_TRANSFER)
+        stats->inTransit++;
+    }
+
+    // Vehicles still on a link belong to their destination's pool and are
+    // released with it
+    for (int k = 0; p->outbox && k < n->partitionCount; k++)
+      free(p->outbox[k].items);
+    free(p->outbox);
+    freeEventHeap(p->heap);
+  }
+  for (int i = 0; i < n->nodeCount; i++) {
+    stats->priorityActivations += n->nodes[i].controller.priorityActivations;
+    n->nodes[i].junction->onDeparture = NULL;
+  }
+
+  free(n->partitions);
+  n->partitions = NULL;
+  return result;
+}
+
+void printNetworkStats(FILE *out, const Network *n, const NetworkStats *s) {
+  fprintf(out,
+          "=== Simulated %.0f s of %d junctions in %.3f s wall time (%ld "
+          "events) ===\n",
+          (double)s->simulated / NSEC_PER_SEC, n->nodeCount, s->wallSeconds,
+          s->events);
+  // Every lane's waits, for the network-wide percentiles
+  LatencyHistogram *all = (LatencyHistogram *)malloc(sizeof(LatencyHistogram));
+  if (all)
+    initLatencyHistogram(all);
+
+  fprintf(out, "Junction    Arrived  Served  Waiting  MaxQueue  Priority  "
+               "P95Wait\n");
+  for (int i = 0; i < n->nodeCount; i++) {
+    const NetworkNode *node = &n->nodes[i];
+    const Junction *j = node->junction;
+    long arrived = 0, served = 0;
+    int waiting = 0, maxQueue = 0;
+    SimTime p95 = 0;
+
+    for (int l = 0; l < j->config.laneCount; l++) {
+      SimTime laneP95 = latencyPercentile(&j->lanes[l].wait, 95);
+      arrived += j->lanes[l].arrivals;
+      served += j->lanes[l].served;
+      waiting += getSize(j->lanes[l].queue);
+      if (j->lanes[l].maxQueue > maxQueue)
+        maxQueue = j->lanes[l].maxQueue;
+      if (laneP95 > p95)
+        p95 = laneP95;
+      if (all)
+        mergeLatency(all, &j->lanes[l].wait);
+    }
+    fprintf(out, "%-10s %8ld  %6ld  %7d  %8d  %8ld  %7.1f\n", node->name,
+            arrived, served, waiting, maxQueue,
+            node->controller.priorityActivations, (double)p95 / NSEC_PER_SEC);
+  }
+  if (all) {
+    LatencySummary wait = getLatencySummary(all);
+    printLatencyLine(out, "Wait, all lanes", &wait);
+    fprintf(out, "\n");
+    free(all);
+  }
+
+  fprintf(out, "Entered: %ld  Transfers: %ld  Exited: %ld  In transit: %ld\n",
+          s->entered, s->transfers, s->exited, s->inTransit);
+  if (s->exited > 0) {
+    fprintf(out, "Mean time in network: %.1f s\n",
+            (double)s->journeyTime / NSEC_PER_SEC / s->exited);
+  }
+  fprintf(out, "Priority mode activations: %ld\n", s->priorityActivations);
+}
+
+int writeNetworkStatsCsv(const char *path, const Network *n) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    perror("Error opening metrics file");
+    return -1;
+  }
+
+  double hours = (double)n->duration / (3600 * NSEC_PER_SEC);
+  fprintf(file, "junction,lane,arrived,dropped,served,waiting,max_queue,"
+                "served_per_hour,%s,%s\n",
+          LATENCY_CSV_HEADER, FLOW_CSV_HEADER);
+  for (int i = 0; i < n->nodeCount; i++) {
+    const Junction *j = n->nodes[i].junction;
+    for (int l = 0; l < j->config.laneCount; l++) {
+      const JunctionLane *lane = &j->lanes[l];
+      LatencySummary wait = getLatencySummary(&lane->wait);
+      fprintf(file, "%s,%s,%ld,%ld,%ld,%d,%d,%.1f,", n->nodes[i].name,
+              j->config.lanes[l].name, lane->arrivals, lane->dropped,
+              lane->served, getSize(lane->queue), lane->maxQueue,
+              hours > 0 ? lane->served / hours : 0);
+      writeLatencyCsv(file, &wait);
+      fprintf(file, ",");
+      writeFlowCsv(file, &lane->flow);
+      fprintf(file, "\n");
+    }
+  }
+
+  fclose(file);
+  return 0;
+}
@@ -0,0 +1,92 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "event_sim.h"
+#include "junction.h"
+#include "signal_control.h"
+
+#define MAX_NODE_NAME 16
+#define DEFAULT_TRAVEL_SEC 30 // grid link travel time
+
+// Where vehicles served on one road of a junction go next
+typedef struct {
+  int junction;   // downstream junction index, -1 = leaves the network
+  char road;      // inbound road at the downstream junction
+  SimTime travel; // time between leaving and joining the downstream queue
+} NetworkLink;
+
+typedef struct {
+  SimTime simulated;
+  double wallSeconds;
+  long events;
+  long entered;        // generated arrivals at the network edge
+  long transfers;      // vehicles handed to a downstream junction
+  long exited;         // vehicles that left the network
+  long inTransit;      // on a link when the run ended
+  SimTime journeyTime; // summed time in the network of exited vehicles
+  long priorityActivations;
+} NetworkStats;
+
+typedef struct Network Network;
+typedef struct NetworkPartition NetworkPartition;
+
+// One junction of the network with its own signals and arrival stream
+typedef struct {
+  char name[MAX_NODE_NAME];
+  Junction *junction;
+  NetworkLink *exits; // per road of the junction
+  bool *fed;          // per road: fed by a link instead of generated arrivals
+  ArrivalStream *arrivals; // per lane, used on roads no link feeds
+  SignalController controller;
+  SharedData signals;
+  Rng rng;
+  unsigned long nextSeq; // events scheduled by this junction
+  int partition;         // worker that owns the junction during a run
+  Network *network;
+} NetworkNode;
+
+struct Network {
+  int nodeCount;
+  NetworkNode *nodes;
+
+  // Run state of runNetworkSimulation()
+  int partitionCount;
+  NetworkPartition *partitions;
+  SimTime lookahead; // shortest travel time between two partitions
+  SimTime duration;
+  pthread_barrier_t barrier;
+};
+
+// Reads a network description:
+//   junction <name> [config-file]
+//   link <from> <road> <to> <road> <travel-seconds>
+// Junctions without a config file use the default 4-arm layout. Returns
+// NULL on error (message printed)
+Network *loadNetwork(const char *path);
+
+// A width x height grid of identical junctions joined by straight-through
+// links: A (north arm) feeds A of the junction below, B (south) the one
+// above, C (east) the one to the west and D (west) the one to the east
+Network *createGridNetwork(int width, int height, const JunctionConfig *cfg,
+                           SimTime travel);
+
+void freeNetwork(Network *n);
+
+// Runs every junction of the network in one simulated clock. Vehicles are
+// generated on roads no link feeds. Needs cfg->duration > 0.
+// With threads > 1 the junctions are split into that many contiguous
+// partitions, each run by its own thread. Partitions advance in windows as
+// long as the shortest link between them, exchanging vehicles at the end of
+// each window, and the results are identical to a single-threaded run
+int runNetworkSimulation(Network *n, const SimConfig *cfg, int threads,
+                         NetworkStats *stats);
+
+void printNetworkStats(FILE *out, const Network *n, const NetworkStats *s);
+// One row per junction lane
+int writeNetworkStatsCsv(const char *path, const Network *n);
+
+#endif
@@ -0,0 +1,260 @@
+#include "queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static QueueSegment *createSegment() {
+  QueueSegment *seg = (QueueSegment *)malloc(sizeof(QueueSegment));
+  if (seg)
+    atomic_init(&seg->next, NULL);
+  return seg;
+}
+
+Queue *createQueue() {
+  Queue *q = (Queue *)aligned_alloc(_Alignof(Queue), sizeof(Queue));
+  QueueSegment *seg = createSegment();
+  if (!q || !seg) {
+    printf("Error: Failed to allocate memory for queue\n");
+    free(q);
+    free(seg);
+    return NULL;
+  }
+  q->head = seg;
+  q->tail = seg;
+  atomic_init(&q->dequeued, 0);
+  atomic_init(&q->enqueued, 0);
+  atomic_init(&q->spare, NULL);
+  return q;
+}
+
+int enqueue(Queue *q, VehicleId v) {
+  if (!q || v == NO_VEHICLE)
+    return -1;
+
+  long n = atomic_load_explicit(&q->enqueued, memory_order_relaxed);
+
+  // Current segment is full: link a new one (recycled if the consumer left
+  // one behind) before the item that needs it becomes visible
+  if (n > 0 && (n & QUEUE_SEGMENT_MASK) == 0) {
+    QueueSegment *seg = atomic_exchange_explicit(&q->spare, NULL,
+                                                 memory_order_acquire);
+    if (seg)
+      atomic_store_explicit(&seg->next, NULL, memory_order_relaxed);
+    else
+      seg = createSegment();
+    if (!seg) {
+      printf("Error: Failed to grow queue, cannot add vehicle %u\n", v);
+      return -1;
+    }
+    atomic_store_explicit(&q->tail->next, seg, memory_order_relaxed);
+    q->tail = seg;
+  }
+
+  q->tail->items[n & QUEUE_SEGMENT_MASK] = v;
+  // Publishes the item (and any new segment) to the consumer
+  atomic_store_explicit(&q->enqueued, n + 1, memory_order_release);
+  return 0;
+}
+
+VehicleId dequeue(Queue *q) {
+  if (!q)
+    return NO_VEHICLE;
+
+  long d = atomic_load_explicit(&q->dequeued, memory_order_relaxed);
+  if (d == atomic_load_explicit(&q->enqueued, memory_order_acquire))
+    return NO_VEHICLE;
+
+  // Finished a segment: advance and offer the old one back to the producer
+  if (d > 0 && (d & QUEUE_SEGMENT_MASK) == 0) {
+    QueueSegment *done = q->head;
+    q->head = atomic_load_explicit(&done->next, memory_order_relaxed);
+    QueueSegment *old = atomic_exchange_explicit(&q->spare, done,
+                                                 memory_order_release);
+    free(old);
+  }
+
+  VehicleId v = q->head->items[d & QUEUE_SEGMENT_MASK];
+  atomic_store_explicit(&q->dequeued, d + 1, memory_order_release);
+  return v;
+}
+
+int isEmpty(Queue *q) { return getSize(q) == 0; }
+
+// Get queue size. From a third thread (e.g. the renderer) this is a snapshot
+int getSize(Queue *q) {
+  if (q == NULL)
+    return 0;
+  long d = atomic_load_explicit(&q->dequeued, memory_order_relaxed);
+  long n = atomic_load_explicit(&q->enqueued, memory_order_relaxed);
+  return n > d ? (int)(n - d) : 0;
+}
+
+VehicleId peek(Queue *q) {
+  if (!q)
+    return NO_VEHICLE;
+
+  long d = atomic_load_explicit(&q->dequeued, memory_order_relaxed);
+  if (d == atomic_load_explicit(&q->enqueued, memory_order_acquire))
+    return NO_VEHICLE;
+
+  // The next item may be the first one of the following segment
+  QueueSegment *seg = q->head;
+  if (d > 0 && (d & QUEUE_SEGMENT_MASK) == 0)
+    seg = atomic_load_explicit(&seg->next, memory_order_relaxed);
+  return seg->items[d & QUEUE_SEGMENT_MASK];
+}
+
+void freeQueue(Queue *q) {
+  if (!q)
+    return;
+
+  // Queued vehicles belong to their pool, only the segments are freed here
+  QueueSegment *seg = q->head;
+  while (seg) {
+    QueueSegment *next = atomic_load(&seg->next);
+    free(seg);
+    seg = next;
+  }
+  free(atomic_load(&q->spare));
+  free(q);
+}
+
+PriorityQueue *createPriorityQueue(int laneCount) {
+  PriorityQueue *pq = (PriorityQueue *)malloc(sizeof(PriorityQueue));
+  LaneInfo *lanes = (LaneInfo *)calloc(laneCount, sizeof(LaneInfo));
+  int *heap = (int *)malloc(sizeof(int) * (laneCount > 0 ? laneCount : 1));
+  if (!pq || !lanes || !heap) {
+    printf("Error: Failed to allocate memory for priority queue\n");
+    free(pq);
+    free(lanes);
+    free(heap);
+    return NULL;
+  }
+
+  pq->lanes = lanes;
+  pq->heap = heap;
+  pq->size = laneCount;
+  pq->logChanges = true;
+
+  // Initialize all lanes with normal priority. Every lane is empty, so lane
+  // order is already a valid heap
+  for (int i = 0; i < laneCount; i++) {
+    pq->lanes[i].laneId = i;
+    pq->lanes[i].priority = 0; // Normal priority
+    pq->lanes[i].vehicleCount = 0;
+    pq->lanes[i].weight = 1;
+    pq->lanes[i].oldest = INT64_MAX;
+    pq->lanes[i].name = "";
+    pq->lanes[i].heapIndex = i;
+    pq->heap[i] = i;
+  }
+
+  return pq;
+}
+
+void setPriorityLane(PriorityQueue *pq, int laneId, const char *name, int on,
+                     int off, int weight) {
+  if (!pq || laneId < 0 || laneId >= pq->size)
+    return;
+  pq->lanes[laneId].name = name;
+  pq->lanes[laneId].priorityOn = on;
+  pq->lanes[laneId].priorityOff = off;
+  pq->lanes[laneId].weight = weight > 0 ? weight : 1;
+}
+
+// Heap order: weighted count, then the oldest waiting vehicle, then lane id,
+// so the top is unique. Priority lanes are left to the priority policy,
+// which checks their thresholds itself
+static bool laneBefore(const LaneInfo *a, const LaneInfo *b) {
+  long aScore = (long)a->weight * a->vehicleCount;
+  long bScore = (long)b->weight * b->vehicleCount;
+  if (aScore != bScore)
+    return aScore > bScore;
+  if (a->oldest != b->oldest)
+    return a->oldest < b->oldest;
+  return a->laneId < b->laneId;
+}
+
+static void placeLane(PriorityQueue *pq, int at, int laneId) {
+  pq->heap[at] = laneId;
+  pq->lanes[laneId].heapIndex = at;
+}
+
+// Restores the heap after the key of the lane at 'at' changed: sift up if
+// it gained (increase-key), else down (decrease-key)
+static void fixHeap(PriorityQueue *pq, int at) {
+  int laneId = pq->heap[at];
+  const LaneInfo *lane = &pq->lanes[laneId];
+
+  while (at > 0) {
+    int parent = (at - 1) / 2;
+    if (!laneBefore(lane, &pq->lanes[pq->heap[parent]]))
+      break;
+    placeLane(pq, at, pq->heap[parent]);
+    at = parent;
+  }
+
+  for (;;) {
+    int child = 2 * at + 1;
+    if (child >= pq->size)
+      break;
+    if (child + 1 < pq->size && laneBefore(&pq->lanes[pq->heap[child + 1]],
+                                           &pq->lanes[pq->heap[child]]))
+      child++;
+    if (!laneBefore(&pq->lanes[pq->heap[child]], lane))
+      break;
+    placeLane(pq, at, pq->heap[child]);
+    at = child;
+  }
+  placeLane(pq, at, laneId);
+}
+
+// Update priority based on vehicle count and the head vehicle's queue time
+void updatePriority(PriorityQueue *pq, int laneId, int count, SimTime oldest) {
+  if (!pq || laneId < 0 || laneId >= pq->size)
+    return;
+
+  LaneInfo *lane = &pq->lanes[laneId];
+  lane->vehicleCount = count;
+  lane->oldest = count > 0 ? oldest : INT64_MAX;
+
+  // Special logic for priority lanes (AL2 by default)
+  if (lane->priorityOn > 0) {
+    if (count > lane->priorityOn) {
+      if (lane->priority != 100 && pq->logChanges) {
+        printf(">>> PRIORITY MODE ACTIVATED: %s has %d vehicles\n",
+               lane->name, count);
+      }
+      lane->priority = 100; // High priority
+    } else if (count < lane->priorityOff) {
+      if (lane->priority == 100 && pq->logChanges) {
+        printf(">>> PRIORITY MODE DEACTIVATED: %s has %d vehicles\n",
+               lane->name, count);
+      }
+      lane->priority = 0; // Back to normal
+    }
+    // In between the thresholds, maintain current priority
+  } else {
+    // Other lanes always have normal priority
+    lane->priority = 0;
+  }
+
+  fixHeap(pq, lane->heapIndex);
+}
+
+// Get the next lane to serve: the top of the heap, -1 if
+// no lane has vehicles
+int getNextLane(PriorityQueue *pq) {
+  if (!pq || pq->size == 0)
+    return -1;
+  const LaneInfo *top = &pq->lanes[pq->heap[0]];
+  return top->vehicleCount > 0 ? top->laneId : -1;
+}
+
+void freePriorityQueue(PriorityQueue *pq) {
+  if (!pq)
+    return;
+  free(pq->lanes);
+  free(pq->heap);
+  free(pq);
+}
@@ -0,0 +1,95 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sim_time.h"
+
+#define QUEUE_SEGMENT_SIZE 256 // vehicles per segment, must be a power of two
+#define QUEUE_SEGMENT_MASK (QUEUE_SEGMENT_SIZE - 1)
+
+// Handle of a vehicle in its junction's VehiclePool (vehicle_pool.h)
+typedef uint32_t VehicleId;
+#define NO_VEHICLE UINT32_MAX
+
+// One vehicle's fields together, for copying a vehicle between pools. Queues
+// and pools hold vehicles as VehicleIds
+typedef struct {
+  char vehicleNumber[10];
+  char road;
+  unsigned char lane; // lane number on the road, 0 = road's first lane
+
+  // Pipeline timestamps in ns, CLOCK_MONOTONIC in real time (shared by all
+  // processes of the machine) or simulated time under the event engines
+  SimTime generatedAt; // created by the generator, carried by the transport
+  SimTime ingestedAt;  // read by the reader thread
+  SimTime queuedAt;    // joined its current lane, in the junction's clock
+  SimTime servedAt;    // left the queue on a green
+} Vehicle;
+
+typedef struct QueueSegment {
+  struct QueueSegment *_Atomic next;
+  VehicleId items[QUEUE_SEGMENT_SIZE];
+} QueueSegment;
+
+// Unbounded lock-free single-producer/single-consumer queue: a linked list of
+// fixed-size segments indexed with a mask. Exactly one thread may enqueue and
+// one thread dequeue/peek at a time; getSize() may be called from any thread.
+// The counters live on separate cache lines so the two sides don't share one
+typedef struct {
+  // Consumer side
+  QueueSegment *head;
+  _Alignas(64) _Atomic long dequeued;
+
+  // Producer side
+  _Alignas(64) QueueSegment *tail;
+  _Atomic long enqueued;
+
+  // One emptied segment handed back from the consumer to the producer
+  _Alignas(64) QueueSegment *_Atomic spare;
+} Queue;
+
+typedef struct {
+  int laneId;
+  int priority; // 100 while a priority lane is active, else 0
+  int vehicleCount;
+  int weight;      // configured lane weight, scales vehicleCount
+  SimTime oldest;  // when the head vehicle joined, INT64_MAX if empty
+  int priorityOn;  // priority when count > priorityOn, 0 = normal lane
+  int priorityOff; // back to normal when count < priorityOff
+  const char *name;
+  int heapIndex; // position of the lane in PriorityQueue.heap
+} LaneInfo;
+
+// Indexed binary max-heap of lanes: each lane knows its heap position, so a
+// changed count moves only that lane, in O(log lanes). The top is the lane
+// to serve next: the largest weight x count, then the oldest waiting vehicle
+typedef struct {
+  LaneInfo *lanes; // by lane id
+  int *heap;       // lane ids in heap order
+  int size;
+  bool logChanges; // print when a lane enters/leaves priority
+} PriorityQueue;
+
+// Queue functions (see the threading rules on Queue)
+Queue *createQueue();
+int enqueue(Queue *q, VehicleId v);
+VehicleId dequeue(Queue *q); // NO_VEHICLE if empty
+int isEmpty(Queue *q);
+int getSize(Queue *q);
+VehicleId peek(Queue *q); // NO_VEHICLE if empty
+void freeQueue(Queue *q);
+
+// Priority queue functions
+PriorityQueue *createPriorityQueue(int laneCount);
+void setPriorityLane(PriorityQueue *pq, int laneId, const char *name, int on,
+                     int off, int weight);
+// New count and head queue time of a lane (increase- or decrease-key)
+void updatePriority(PriorityQueue *pq, int laneId, int count, SimTime oldest);
+int getNextLane(PriorityQueue *pq);
+void freePriorityQueue(PriorityQueue *pq);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** pseudo-random generator. Every run, junction or thread owns
+// its own Rng, so results are reproducible from the seed and no locking is
+// needed
+typedef struct {
+  uint64_t s[4];
+} Rng;
+
+// SplitMix64 step, used to expand seeds into generator state
+static inline uint64_t splitMix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Seeds stream number 'stream' of a master seed. Each replication, junction
+// or worker takes its own stream, so streams don't depend on thread timing
+static inline void rngSeed(Rng *rng, uint64_t seed, uint64_t stream) {
+  uint64_t x = stream;
+  x = seed ^ splitMix64(&x);
+  for (int i = 0; i < 4; i++)
+    rng->s[i] = splitMix64(&x);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rngNext(Rng *rng) {
+  uint64_t *s = rng->s;
+  uint64_t result = rotl64(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl64(s[3], 45);
+  return result;
+}
+
+// Uniform integer in [0, n) by multiply-shift, bias is negligible for the
+// small ranges used here
+static inline uint32_t rngBelow(Rng *rng, uint32_t n) {
+  return (uint32_t)(((rngNext(rng) >> 32) * n) >> 32);
+}
+
+// Uniform double in [0, 1)
+static inline double rngUniform(Rng *rng) {
+  return (double)(rngNext(rng) >> 11) * 0x1.0p-53;
+}
+
+// Seeds 'child' from the next output of 'parent', giving a sub-stream (one
+// per lane, say) of an already seeded stream
+static inline void rngSplit(Rng *parent, Rng *child) {
+  rngSeed(child, rngNext(parent), 0);
+}
+
+#endif
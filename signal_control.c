@@ -0,0 +1,183 @@
+#include "signal_control.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The junction logic is a small state machine so the same rules can be driven
+// either by the real-time thread (sleeping between steps) or by the
+// discrete-event engine (scheduling the next step in simulated time). Which
+// road gets green and for how long is up to the policy (signal_policy.c)
+void initController(SignalController *c, const Junction *j, bool verbose) {
+  memset(c, 0, sizeof(*c));
+  c->policy = findSignalPolicy(j->config.policy);
+  if (!c->policy)
+    c->policy = &SIGNAL_POLICIES[0];
+  c->phase = CTRL_DECIDE;
+  c->cycleRoad = -1;
+  c->verbose = verbose;
+}
+
+// Serves one vehicle from lane i, returns the remaining size or -1 if the lane
+// was already empty
+static int serveVehicle(SignalController *c, Junction *j, int i) {
+  int remaining = -1;
+
+  VehicleId v = dequeue(j->lanes[i].queue);
+  if (v != NO_VEHICLE) {
+    remaining = getSize(j->lanes[i].queue);
+    if (c->verbose && c->green.priority) {
+      printf("  >> Served Priority %s: %s (Remaining: %d)\n",
+             j->config.lanes[i].name,
+             VEHICLE_FIELD(j->pool, v, vehicleNumber), remaining);
+    }
+    j->lanes[i].served++;
+    SimTime servedAt = junctionTime(j);
+    VEHICLE_FIELD(j->pool, v, servedAt) = servedAt;
+    recordLatency(&j->lanes[i].wait,
+                  servedAt - VEHICLE_FIELD(j->pool, v, queuedAt));
+    observeService(&j->lanes[i].flow, servedAt, remaining);
+    if (j->onDeparture)
+      j->onDeparture(j, i, v, j->departureCtx);
+    else
+      poolFree(j->pool, v);
+    updatePriority(j->priority, i, remaining, laneHeadQueuedAt(j, i));
+  }
+
+  return remaining;
+}
+
+// Gives lane i one service interval of green: a vehicle leaves for every
+// headway of green banked, so lanes with the default headway serve one per
+// interval and slower lanes skip some. Returns false if the lane was empty
+static bool dischargeLane(SignalController *c, Junction *j, int i) {
+  JunctionLane *lane = &j->lanes[i];
+  SimTime headway = j->config.lanes[i].headway;
+
+  if (isEmpty(lane->queue)) {
+    lane->credit = 0; // an empty lane banks no green
+    return false;
+  }
+  lane->credit += VEHICLE_SERVICE_NS;
+  while (lane->credit >= headway) {
+    int remaining = serveVehicle(c, j, i);
+    if (remaining < 0)
+      break;
+    lane->credit -= headway;
+    if (i == c->green.lane)
+      c->laneCount = remaining;
+    if (remaining == 0) {
+      lane->credit = 0;
+      break;
+    }
+  }
+  return true;
+}
+
+// One service interval for every lane of the green, true if any of them
+// still had vehicles
+static bool serveGreen(SignalController *c, Junction *j) {
+  if (c->green.lane >= 0) {
+    bool busy = dischargeLane(c, j, c->green.lane);
+    if (!busy)
+      c->laneCount = 0;
+    return busy;
+  }
+
+  bool busy = false;
+  const RoadConfig *road = &j->config.roads[c->green.road];
+  for (int i = road->firstLane; i < road->firstLane + road->laneCount; i++) {
+    if (dischargeLane(c, j, i))
+      busy = true;
+  }
+  return busy;
+}
+
+// A new green: the lanes start without banked time and the flow estimates
+// without a previous departure
+static void startGreenLanes(Junction *j, const GreenPlan *g) {
+  const RoadConfig *road = &j->config.roads[g->road];
+  for (int i = road->firstLane; i < road->firstLane + road->laneCount; i++) {
+    if (g->lane < 0 || g->lane == i) {
+      j->lanes[i].credit = 0;
+      startGreen(&j->lanes[i].flow);
+    }
+  }
+}
+
+// Runs one step of the signal logic and returns how long (in ns) the junction
+// stays in the resulting state before the next step is due
+SimTime controllerStep(SignalController *c, SharedData *sharedData,
+                       Junction *j) {
+  if (c->phase == CTRL_DECIDE) {
+    if (!j->simulated)
+      syncPriorities(j);
+    GreenPlan plan = {-1, -1, 0, 0, false, false, IDLE_WAIT_NS};
+    c->policy->decide(c, j, &plan);
+    if (plan.road < 0)
+      return plan.wait;
+
+    c->green = plan;
+    c->servedCount = 0;
+    if (plan.lane >= 0)
+      c->laneCount = getSize(j->lanes[plan.lane].queue);
+    startGreenLanes(j, &plan);
+    c->phase = CTRL_SERVE;
+    sharedData->nextLight = plan.road + 1; // 1=A, 2=B...
+    return LIGHT_TRANSITION_NS;
+  }
+
+  // Serve until the plan runs out, the single green lane drops below its
+  // threshold or (unless the green is fixed) the lanes are empty
+  GreenPlan *g = &c->green;
+  if (c->servedCount >= g->maxServes && c->policy->keepGreen &&
+      roadVehicleCount(j, g->road) > 0 && c->policy->keepGreen(c, j))
+    c->servedCount = 0;
+
+  bool holding = g->lane < 0 || c->laneCount >= g->holdWhile;
+  if (c->servedCount < g->maxServes && holding) {
+    if (serveGreen(c, j) || g->fixed) {
+      c->servedCount++;
+      return VEHICLE_SERVICE_NS;
+    }
+  }
+
+  if (c->verbose && g->priority) {
+    printf("<<< PRIORITY MODE ENDED: %s count dropped to %d (<%d)\n",
+           j->config.lanes[g->lane].name, c->laneCount, g->holdWhile);
+  }
+  sharedData->nextLight = 0; // Red
+  c->phase = CTRL_DECIDE;
+  return LIGHT_TRANSITION_NS;
+}
+
+// Real-time driver: runs the controller against the wall clock
+void *checkQueue(void *arg) {
+  SharedData *sharedData = (SharedData *)arg;
+  SignalController controller;
+
+  initController(&controller, sharedData->junction, true);
+  printf("Traffic processing thread started\n");
+
+  // Sleeps in slices of at most SNAPSHOT_INTERVAL_NS when publishing, so
+  // the snapshot follows arrivals between controller steps
+  SimTime due = monotonicNs();
+  while (!sharedData->stopSimulation) {
+    SimTime now = monotonicNs();
+    if (now >= due) {
+      due = now + controllerStep(&controller, sharedData, sharedData->junction);
+      now = monotonicNs();
+    }
+    if (!sharedData->snapshot) {
+      sleepNs(due - now);
+      continue;
+    }
+    publishSnapshot(sharedData->snapshot, sharedData->junction,
+                    sharedData->nextLight);
+    sleepNs(due - now < SNAPSHOT_INTERVAL_NS ? due - now
+                                             : SNAPSHOT_INTERVAL_NS);
+  }
+
+  printf("Traffic processing thread stopped\n");
+  return NULL;
+}
@@ -0,0 +1,88 @@
+#ifndef SIGNAL_CONTROL_H
+#define SIGNAL_CONTROL_H
+
+#include <stdbool.h>
+
+#include "junction.h"
+#include "junction_snapshot.h"
+#include "sim_time.h"
+
+// Signal timing, all in nanoseconds of (real or simulated) time
+#define LIGHT_TRANSITION_NS (1 * NSEC_PER_SEC) // all-red / switch time
+#define VEHICLE_SERVICE_NS 750000000LL         // time to serve one vehicle
+#define IDLE_WAIT_NS (1 * NSEC_PER_SEC)        // re-check when all empty
+
+// Lights are numbered by road: 0 = all red, n = road n-1 green. With a
+// snapshot the real-time controller publishes the lane counts and light
+// for other threads every SNAPSHOT_INTERVAL_NS
+typedef struct {
+  int nextLight;
+  bool stopSimulation;
+  Junction *junction;
+  JunctionSnapshot *snapshot; // optional
+} SharedData;
+
+typedef enum {
+  CTRL_DECIDE, // all red: ask the policy for the next green
+  CTRL_SERVE   // green lanes discharge every VEHICLE_SERVICE_NS
+} ControllerPhase;
+
+// One green as decided by a policy
+typedef struct {
+  int road;      // road to turn green, -1 = stay red for 'wait'
+  int lane;      // serve only this lane of the road, -1 = all of its lanes
+  int maxServes; // service intervals before the light changes
+  int holdWhile; // with 'lane': end once its count drops below this
+  bool fixed;    // hold the green for all maxServes even on empty lanes
+  bool priority; // priority mode, for the log
+  SimTime wait;  // road == -1: time until the policy is asked again
+} GreenPlan;
+
+typedef struct SignalController SignalController;
+
+// Signal-control strategy. decide() runs whenever the lights are red and
+// plans the next green; keepGreen() (optional) may extend a green that used
+// up its maxServes while its lanes still hold vehicles. Policies may update
+// the lanes' flow estimates but nothing else of the junction
+typedef struct {
+  const char *name;
+  const char *summary;
+  void (*decide)(SignalController *c, Junction *j, GreenPlan *plan);
+  bool (*keepGreen)(SignalController *c, Junction *j);
+} SignalPolicy;
+
+// The controller's generic state plus the scratch the built-in policies keep
+// between decisions
+struct SignalController {
+  const SignalPolicy *policy;
+  ControllerPhase phase;
+  GreenPlan green;  // current (or last) green
+  int servedCount;  // service intervals used in the current green
+  int laneCount;    // last known count of green.lane
+  int cycleRoad;    // next road of a round-robin cycle, -1 = between cycles
+  int quantum;      // vehicles per lane per green of the current cycle
+  bool anyServed;   // some road of the current cycle had vehicles
+  bool verbose;
+  long priorityActivations;
+};
+
+#define DEFAULT_SIGNAL_POLICY "priority"
+
+extern const SignalPolicy SIGNAL_POLICIES[];
+extern const int SIGNAL_POLICY_COUNT;
+
+// Looks up a built-in policy by name, NULL if there is none
+const SignalPolicy *findSignalPolicy(const char *name);
+
+// Uses the policy named in the junction's config
+void initController(SignalController *c, const Junction *j, bool verbose);
+
+// Runs one step of the signal logic and returns how long (in ns) the junction
+// stays in the resulting state before the next step is due
+SimTime controllerStep(SignalController *c, SharedData *sharedData,
+                       Junction *j);
+
+// Real-time driver thread, arg is a SharedData*
+void *checkQueue(void *arg);
+
+#endif
@@ -0,0 +1,278 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "signal_control.h"
+
+// Built-in signal policies. Each one only plans greens; the controller turns
+// the plans into light changes and served vehicles
+
+#define FIXED_GREEN_SERVICES 8    // fixed-time green, 6 s
+#define PRESSURE_SLOT_SERVICES 4  // max-pressure decision slot, 3 s
+#define WEIGHTED_BASE_SERVICES 4  // weighted round robin green per weight
+
+// Bounds of the adaptive policy's Webster plan, in s
+#define ADAPTIVE_MIN_CYCLE_SEC 20.0
+#define ADAPTIVE_MAX_CYCLE_SEC 120.0
+#define ADAPTIVE_MIN_GREEN_SEC 2.0
+#define ADAPTIVE_MAX_FLOW_RATIO 0.9 // above this the cycle is the longest
+
+// First road from 'from' on with waiting vehicles, roadCount if there is none
+static int nextWaitingRoad(const Junction *j, int from) {
+  while (from < j->config.roadCount && roadVehicleCount(j, from) == 0)
+    from++;
+  return from;
+}
+
+// Moves the round-robin cycle on to the next road with waiting vehicles and
+// plans 'serves' intervals for it. At the end of the cycle the plan stays red
+// for no time if the cycle served anything, else for the idle wait
+static void nextCycleRoad(SignalController *c, const Junction *j,
+                          GreenPlan *plan, int serves) {
+  c->cycleRoad = nextWaitingRoad(j, c->cycleRoad);
+  if (c->cycleRoad < j->config.roadCount) {
+    c->anyServed = true;
+    plan->road = c->cycleRoad++;
+    plan->maxServes = serves;
+    return;
+  }
+  c->cycleRoad = -1;
+  plan->wait = c->anyServed ? 0 : IDLE_WAIT_NS;
+}
+
+// The original rules: a priority lane above its 'on' threshold takes the
+// green until it drops below 'off'; otherwise every road in turn serves the
+// average queue of the normal lanes
+static void decidePriority(SignalController *c, Junction *j, GreenPlan *plan) {
+  const JunctionConfig *cfg = &j->config;
+
+  if (c->cycleRoad >= 0) {
+    nextCycleRoad(c, j, plan, c->quantum);
+    return;
+  }
+
+  // 1. Check priority lanes (AL2 by default)
+  for (int i = 0; i < cfg->laneCount; i++) {
+    const LaneConfig *lane = &cfg->lanes[i];
+    int count = getSize(j->lanes[i].queue);
+    if (lane->priorityOn > 0 && count > lane->priorityOn) {
+      if (c->verbose) {
+        printf("\n>>> PRIORITY MODE ACTIVATED: %s has %d vehicles (>%d)\n",
+               lane->name, count, lane->priorityOn);
+      }
+      c->priorityActivations++;
+      plan->road = lane->roadIndex;
+      plan->lane = i;
+      plan->maxServes = INT_MAX;
+      plan->holdWhile = lane->priorityOff;
+      plan->priority = true;
+      return;
+    }
+  }
+
+  // 2. Normal Condition: serve the average of the normal lanes per green.
+  // Ensure at least 1 vehicle is served if the average is low due to
+  // integer division
+  int total = 0, normalLanes = 0;
+  for (int i = 0; i < cfg->laneCount; i++) {
+    if (cfg->lanes[i].priorityOn == 0) {
+      total += getSize(j->lanes[i].queue);
+      normalLanes++;
+    }
+  }
+  c->quantum = normalLanes > 0 ? total / normalLanes : 0;
+  if (c->quantum < 1)
+    c->quantum = 1;
+  c->cycleRoad = 0;
+  c->anyServed = false;
+  plan->wait = 0;
+}
+
+// Every road in turn for the same green, whether anyone waits or not
+static void decideFixed(SignalController *c, Junction *j, GreenPlan *plan) {
+  if (c->cycleRoad < 0 || c->cycleRoad >= j->config.roadCount)
+    c->cycleRoad = 0;
+  plan->road = c->cycleRoad++;
+  plan->maxServes = FIXED_GREEN_SERVICES;
+  plan->fixed = true;
+}
+
+// Road with the most waiting vehicles; ties go to the first one after the
+// last green so equal roads take turns. Returns -1 if nothing waits
+static int maxPressureRoad(const Junction *j, int last) {
+  int roads = j->config.roadCount;
+  int best = -1, bestCount = 0;
+  for (int k = 1; k <= roads; k++) {
+    int r = (last + k) % roads;
+    int count = roadVehicleCount(j, r);
+    if (count > bestCount) {
+      best = r;
+      bestCount = count;
+    }
+  }
+  return best;
+}
+
+// Max-pressure in fixed slots. A junction can't see the queues downstream of
+// it, so a road's pressure is its own waiting vehicles
+static void decideMaxPressure(SignalController *c, Junction *j,
+                              GreenPlan *plan) {
+  plan->road = maxPressureRoad(j, c->green.road);
+  plan->maxServes = PRESSURE_SLOT_SERVICES;
+}
+
+// Keeps the green for another slot while the road still has the most
+// pressure, without a light change
+static bool keepMaxPressure(SignalController *c, Junction *j) {
+  int road = c->green.road;
+  int count = roadVehicleCount(j, road);
+  for (int r = 0; r < j->config.roadCount; r++) {
+    if (r != road && roadVehicleCount(j, r) > count)
+      return false;
+  }
+  return true;
+}
+
+// The road of the top lane of the lane heap (the longest weighted queue), for
+// as many intervals as that lane holds
+static void decideLongestQueue(SignalController *c, Junction *j,
+                               GreenPlan *plan) {
+  (void)c;
+  int longest = getNextLane(j->priority);
+  if (longest < 0)
+    return;
+  plan->road = j->config.lanes[longest].roadIndex;
+  plan->maxServes = j->priority->lanes[longest].vehicleCount;
+}
+
+// Every road with waiting vehicles in turn, each green as long as the
+// largest weight among its lanes
+static void decideWeighted(SignalController *c, Junction *j, GreenPlan *plan) {
+  if (c->cycleRoad < 0) {
+    c->cycleRoad = 0;
+    c->anyServed = false;
+  }
+  // Weight of the road nextCycleRoad() will pick
+  int weight = 1;
+  int r = nextWaitingRoad(j, c->cycleRoad);
+  if (r < j->config.roadCount) {
+    const RoadConfig *road = &j->config.roads[r];
+    for (int i = road->firstLane; i < road->firstLane + road->laneCount; i++) {
+      if (j->config.lanes[i].weight > weight)
+        weight = j->config.lanes[i].weight;
+    }
+  }
+  nextCycleRoad(c, j, plan, WEIGHTED_BASE_SERVICES * weight);
+}
+
+// Flow ratio of a road: that of its most loaded lane
+static double roadFlowRatio(const Junction *j, int r) {
+  const RoadConfig *road = &j->config.roads[r];
+  double y = 0;
+  for (int i = road->firstLane; i < road->firstLane + road->laneCount; i++) {
+    double lane = flowRatio(&j->lanes[i].flow);
+    if (lane > y)
+      y = lane;
+  }
+  return y;
+}
+
+// Webster's delay-minimising timing from the current estimates: with the
+// lost time L of all phases and Y the sum of the roads' flow ratios, the
+// cycle is C = (1.5 L + 5) / (1 - Y) and the green left after L is split in
+// proportion to each road's ratio. The greens go into the lanes' estimates
+static void planWebster(Junction *j) {
+  const JunctionConfig *cfg = &j->config;
+  SimTime now = junctionTime(j);
+  for (int i = 0; i < cfg->laneCount; i++)
+    observeArrivals(&j->lanes[i].flow, j->lanes[i].arrivals, now);
+
+  double total = 0;
+  for (int r = 0; r < cfg->roadCount; r++)
+    total += roadFlowRatio(j, r);
+
+  // Each phase loses the switch to green and the switch back to red
+  double lost =
+      cfg->roadCount * 2.0 * (double)LIGHT_TRANSITION_NS / NSEC_PER_SEC;
+  double cycle = ADAPTIVE_MAX_CYCLE_SEC;
+  if (total < ADAPTIVE_MAX_FLOW_RATIO)
+    cycle = (1.5 * lost + 5) / (1 - total);
+  if (cycle < ADAPTIVE_MIN_CYCLE_SEC)
+    cycle = ADAPTIVE_MIN_CYCLE_SEC;
+  if (cycle > ADAPTIVE_MAX_CYCLE_SEC)
+    cycle = ADAPTIVE_MAX_CYCLE_SEC;
+
+  for (int r = 0; r < cfg->roadCount; r++) {
+    const RoadConfig *road = &cfg->roads[r];
+    double green = total > 0 ? (cycle - lost) * roadFlowRatio(j, r) / total : 0;
+    if (green < ADAPTIVE_MIN_GREEN_SEC)
+      green = ADAPTIVE_MIN_GREEN_SEC;
+    // Room for two departures from the slowest lane, so each lane keeps
+    // discharging and its headway keeps being measured
+    for (int i = road->firstLane; i < road->firstLane + road->laneCount; i++) {
+      if (green < 2 * j->lanes[i].flow.headway)
+        green = 2 * j->lanes[i].flow.headway;
+    }
+    for (int i = road->firstLane; i < road->firstLane + road->laneCount; i++)
+      j->lanes[i].flow.green = green;
+  }
+}
+
+// Every road with waiting vehicles in turn for its Webster green, planned
+// afresh at the start of each cycle; a green ends early once its lanes empty
+static void decideAdaptive(SignalController *c, Junction *j, GreenPlan *plan) {
+  if (c->cycleRoad < 0) {
+    planWebster(j);
+    c->cycleRoad = 0;
+    c->anyServed = false;
+  }
+  int serves = 1;
+  int r = nextWaitingRoad(j, c->cycleRoad);
+  if (r < j->config.roadCount) {
+    double green = j->lanes[j->config.roads[r].firstLane].flow.green;
+    serves = (int)ceil(green * NSEC_PER_SEC / VEHICLE_SERVICE_NS);
+  }
+  nextCycleRoad(c, j, plan, serves);
+}
+
+const SignalPolicy SIGNAL_POLICIES[] = {
+    {"priority", "priority lanes above their threshold, else round robin "
+                 "serving the average queue",
+     decidePriority, NULL},
+    {"fixed-time", "fixed-time cycle, 6 s green per road", decideFixed,
+     NULL},
+    {"max-pressure", "road with the most waiting vehicles, 3 s slots",
+     decideMaxPressure, keepMaxPressure},
+    {"longest-queue", "road of the longest lane until that lane is served",
+     decideLongestQueue, NULL},
+    {"weighted-round-robin", "round robin, 3 s green per unit of lane weight",
+     decideWeighted, NULL},
+    {"adaptive", "round robin, Webster greens from estimated saturation "
+                 "flows and demand",
+     decideAdaptive, NULL},
+};
+const int SIGNAL_POLICY_COUNT =
+    (int)(sizeof(SIGNAL_POLICIES) / sizeof(SIGNAL_POLICIES[0]));
+
+// Short names accepted for some of the policies above
+static const struct {
+  const char *alias;
+  const char *name;
+} POLICY_ALIASES[] = {
+    {"fixed", "fixed-time"},
+    {"weighted", "weighted-round-robin"},
+};
+
+const SignalPolicy *findSignalPolicy(const char *name) {
+  for (size_t i = 0; i < sizeof(POLICY_ALIASES) / sizeof(POLICY_ALIASES[0]);
+       i++) {
+    if (strcmp(POLICY_ALIASES[i].alias, name) == 0)
+      name = POLICY_ALIASES[i].name;
+  }
+  for (int i = 0; i < SIGNAL_POLICY_COUNT; i++) {
+    if (strcmp(SIGNAL_POLICIES[i].name, name) == 0)
+      return &SIGNAL_POLICIES[i];
+  }
+  return NULL;
+}
@@ -0,0 +1,26 @@
+#ifndef SIM_TIME_H
+#define SIM_TIME_H
+
+#include <stdint.h>
+#include <time.h>
+
+typedef int64_t SimTime; // nanoseconds
+
+#define NSEC_PER_SEC 1000000000LL
+
+// Current CLOCK_MONOTONIC time in nanoseconds
+static inline SimTime monotonicNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (SimTime)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static inline void sleepNs(SimTime ns) {
+  if (ns <= 0)
+    return;
+  struct timespec ts = {ns / NSEC_PER_SEC, ns % NSEC_PER_SEC};
+  while (nanosleep(&ts, &ts) != 0)
+    ;
+}
+
+#endif
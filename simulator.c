@@ -5,11 +5,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
-#include <unistd.h>
 
-#define MAX_QUEUE_SIZE 10
-#define MAX_LINE_LENGTH 20
+#include "frame_clock.h"
+#include "junction.h"
+#include "signal_control.h"
+#include "vehicle_motion.h"
+#include "vehicle_reader.h"
+
 #define MAIN_FONT "/usr/share/fonts/TTF/DejaVuSans.ttf"
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 800
@@ -17,194 +19,58 @@
 #define ROAD_WIDTH 150
 #define LANE_WIDTH 50
 #define ARROW_SIZE 15
-
-const char *VEHICLE_FILE = "vehicles.data";
-// queue starts
+#define TEXT_CACHE_SIZE 64 // rendered strings kept as textures
+#define CAR_SIZE 20
+#define CAR_PITCH 25 // car plus gap
+#define MAX_VISIBLE_CARS (WINDOW_WIDTH / 2 / CAR_PITCH + 1) // per arm
+#define DEFAULT_QUEUE_DETAIL 10
+#define FRAME_OVERLAY_INTERVAL_NS NSEC_PER_SEC    // on-screen frame timing
+#define FRAME_LOG_INTERVAL_NS (10 * NSEC_PER_SEC) // frame timing on stdout
+#define MAX_CACHED_TEXT 48
+
+// Junction shared with the worker threads, read by the renderer
+Junction *junction = NULL;
+
+// Queues up to this long are drawn car by car, longer ones as a bar with
+// the count (--queue-detail)
+int queueDetail = DEFAULT_QUEUE_DETAIL;
+
+// One rendered string; texture NULL = free slot
 typedef struct {
-  char vehicleNumber[10];
-  char road;
-  time_t arrivalTime;
-} Vehicle;
-
+  char text[MAX_CACHED_TEXT];
+  TTF_Font *font;
+  SDL_Texture *texture;
+  int w, h;
+  unsigned long lastUsed;
+} CachedText;
+
+// Rendered strings, least recently used replaced first. Labels never change
+// and a lane count only when a vehicle arrives or leaves, so most frames
+// rasterize no text at all. UI thread only
 typedef struct {
-  Vehicle *items[MAX_QUEUE_SIZE];
-  int front;
-  int rear;
-  int size;
-} Queue;
+  CachedText entries[TEXT_CACHE_SIZE];
+  unsigned long clock;
+  long hits;
+  long misses;
+} TextCache;
 
-typedef struct {
-  int laneId;
-  int priority;
-  int vehicleCount;
-} LaneInfo;
+TextCache textCache;
 
+// The cars of the diagram as the renderer animates them between snapshots.
+// UI thread only
 typedef struct {
-  LaneInfo lanes[4];
-  int size;
-} PriorityQueue;
-
-typedef struct {
-  int currentLight;
-  int nextLight;
-  bool stopSimulation;
-} SharedData;
+  VehicleMotion motion;
+  long *served; // per lane, as of the last snapshot fed in
+  bool bar[4];  // arm was drawn as a queue bar
+  bool started; // a snapshot was fed in
+} CarAnimation;
 
 void displayText(SDL_Renderer *renderer, TTF_Font *font, char *text, int x,
                  int y);
 
-Queue *createQueue() {
-  Queue *q = (Queue *)malloc(sizeof(Queue));
-  if (!q) {
-    printf("Error: Failed to allocate memory for queue\n");
-    return NULL;
-  }
-  q->front = 0;
-  q->rear = -1;
-  q->size = 0;
-  return q;
-}
-
-int enqueue(Queue *q, Vehicle *v) {
-  if (!q || !v)
-    return -1;
-
-  if (q->size >= MAX_QUEUE_SIZE) {
-    printf("Warning: Queue is full, cannot add vehicle %s\n", v->vehicleNumber);
-    return -1;
-  }
-
-  q->rear = (q->rear + 1) % MAX_QUEUE_SIZE;
-  q->items[q->rear] = v;
-  q->size++;
-  return 0;
-}
-
-Vehicle *dequeue(Queue *q) {
-  if (!q || q->size == 0) {
-    return NULL;
-  }
-
-  Vehicle *v = q->items[q->front];
-  q->front = (q->front + 1) % MAX_QUEUE_SIZE;
-  q->size--;
-  return v;
-}
-int isEmpty(Queue *q) { return (q == NULL || q->size == 0); }
-
-// Get queue size
-int getSize(Queue *q) { return (q == NULL) ? 0 : q->size; }
-Vehicle *peek(Queue *q) {
-  if (isEmpty(q))
-    return NULL;
-  return q->items[q->front];
-}
-void freeQueue(Queue *q) {
-  if (!q)
-    return;
-
-  while (!isEmpty(q)) {
-    Vehicle *v = dequeue(q);
-    free(v);
-  }
-  free(q);
-}
-
-PriorityQueue *createPriorityQueue() {
-  PriorityQueue *pq = (PriorityQueue *)malloc(sizeof(PriorityQueue));
-  if (!pq) {
-    printf("Error: Failed to allocate memory for priority queue\n");
-    return NULL;
-  }
-
-  pq->size = 4;
-
-  // Initialize all lanes with normal priority
-  for (int i = 0; i < 4; i++) {
-    pq->lanes[i].laneId = i;
-    pq->lanes[i].priority = 0; // Normal priority
-    pq->lanes[i].vehicleCount = 0;
-  }
-
-  return pq;
-}
-
-// Update priority based on vehicle count
-void updatePriority(PriorityQueue *pq, int laneId, int count) {
-  if (!pq || laneId < 0 || laneId >= 4)
-    return;
-
-  pq->lanes[laneId].vehicleCount = count;
-
-  // Special logic for AL2 (lane 0) - priority lane
-  if (laneId == 0) {
-    if (count > 7) {               // Trigger at 8 (near capacity of 10)
-      pq->lanes[0].priority = 100; // High priority
-      printf(">>> PRIORITY MODE ACTIVATED: AL2 has %d vehicles\n", count);
-    } else if (count < 4) {
-      pq->lanes[0].priority = 0; // Back to normal
-      if (pq->lanes[0].priority == 100) {
-        printf(">>> PRIORITY MODE DEACTIVATED: AL2 has %d vehicles\n", count);
-      }
-    }
-    // Between 5 and 10, maintain current priority
-  } else {
-    // Other lanes always have normal priority
-    pq->lanes[laneId].priority = 0;
-  }
-}
-
-// Get the next lane to serve based on priority
-int getNextLane(PriorityQueue *pq) {
-  if (!pq)
-    return 0;
-
-  int maxPriority = -1;
-  int selectedLane = -1;
-
-  // Find lane with highest priority that has vehicles waiting
-  for (int i = 0; i < 4; i++) {
-    if (pq->lanes[i].vehicleCount > 0 && pq->lanes[i].priority > maxPriority) {
-      maxPriority = pq->lanes[i].priority;
-      selectedLane = i;
-    }
-  }
-
-  // If no priority lane, use round-robin on lanes with vehicles
-  if (selectedLane == -1) {
-    for (int i = 0; i < 4; i++) {
-      if (pq->lanes[i].vehicleCount > 0) {
-        selectedLane = i;
-        break;
-      }
-    }
-  }
-
-  return selectedLane;
-}
-
-Queue *queueA = NULL;
-Queue *queueB = NULL;
-Queue *queueC = NULL;
-Queue *queueD = NULL;
-
-PriorityQueue *lanePriorityQueue = NULL;
-
-pthread_mutex_t queueMutex;
-
-void freePriorityQueue(PriorityQueue *pq) {
-  if (pq)
-    free(pq);
-}
-
-void printMessageHelper(const char *message, int count) {
-  for (int i = 0; i < count; i++)
-    printf("%s\n", message);
-}
-
 //---------------------------------------------------------------------------GRAPHICS--------------------------------------------------------------------//
 
-bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer) {
+bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer, bool vsync) {
   if (SDL_Init(SDL_INIT_VIDEO) < 0) {
     SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
     return false;
@@ -224,7 +90,10 @@ bool initializeSDL(SDL_Window **window, SDL_Renderer **renderer) {
     return false;
   }
 
-  *renderer = SDL_CreateRenderer(*window, -1, SDL_RENDERER_ACCELERATED);
+  Uint32 flags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE;
+  if (vsync)
+    flags |= SDL_RENDERER_PRESENTVSYNC;
+  *renderer = SDL_CreateRenderer(*window, -1, flags);
   // if you have high resolution monitor 2K or 4K then scale
   SDL_RenderSetScale(*renderer, SCALE, SCALE);
 
@@ -380,406 +249,490 @@ void drawRoadsAndLane(SDL_Renderer *renderer, TTF_Font *font) {
   }
 }
 
-void displayText(SDL_Renderer *renderer, TTF_Font *font, char *text, int x,
-                 int y) {
-  if (!font)
+// (Re)draws the static layer into the background texture, e.g. after the
+// renderer lost its target textures
+bool renderBackground(SDL_Renderer *renderer, SDL_Texture *background,
+                      TTF_Font *font) {
+  if (SDL_SetRenderTarget(renderer, background) < 0) {
+    SDL_Log("Failed to draw background texture: %s", SDL_GetError());
+    return false;
+  }
+  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+  SDL_RenderClear(renderer);
+  drawRoadsAndLane(renderer, font);
+  SDL_SetRenderTarget(renderer, NULL);
+  return true;
+}
+
+// The roads, lane dividers and labels never change, so they are drawn once
+// into a texture and copied to the screen each frame. Returns NULL if the
+// renderer can't draw to textures; the caller then draws them directly
+SDL_Texture *createBackground(SDL_Renderer *renderer, TTF_Font *font) {
+  SDL_Texture *background =
+      SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                        SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+  if (!background) {
+    SDL_Log("No background texture, drawing roads every frame: %s",
+            SDL_GetError());
+    return NULL;
+  }
+  if (!renderBackground(renderer, background, font)) {
+    SDL_DestroyTexture(background);
+    return NULL;
+  }
+  return background;
+}
+
+// Starts a frame with the static layer
+void drawBackground(SDL_Renderer *renderer, SDL_Texture *background,
+                    TTF_Font *font) {
+  if (background) {
+    SDL_RenderCopy(renderer, background, NULL, NULL);
     return;
+  }
+  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+  SDL_RenderClear(renderer);
+  drawRoadsAndLane(renderer, font);
+}
 
+// Rasterizes text into a new texture, NULL on failure
+SDL_Texture *renderText(SDL_Renderer *renderer, TTF_Font *font,
+                        const char *text, int *w, int *h) {
   SDL_Color textColor = {0, 0, 0, 255};
   SDL_Surface *textSurface = TTF_RenderText_Solid(font, text, textColor);
   if (!textSurface)
-    return;
+    return NULL;
 
   SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, textSurface);
   SDL_FreeSurface(textSurface);
 
-  if (!texture)
+  if (texture)
+    SDL_QueryTexture(texture, NULL, NULL, w, h);
+  return texture;
+}
+
+// Cached texture of text, rendering it into the least recently used slot if
+// needed. NULL if it can't be rendered
+CachedText *findCachedText(SDL_Renderer *renderer, TTF_Font *font,
+                           const char *text) {
+  CachedText *victim = &textCache.entries[0];
+  textCache.clock++;
+  for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+    CachedText *entry = &textCache.entries[i];
+    if (entry->texture && entry->font == font &&
+        strcmp(entry->text, text) == 0) {
+      entry->lastUsed = textCache.clock;
+      textCache.hits++;
+      return entry;
+    }
+    if (!victim->texture)
+      continue;
+    if (!entry->texture || entry->lastUsed < victim->lastUsed)
+      victim = entry;
+  }
+
+  textCache.misses++;
+  if (victim->texture)
+    SDL_DestroyTexture(victim->texture);
+  victim->texture = renderText(renderer, font, text, &victim->w, &victim->h);
+  if (!victim->texture)
+    return NULL;
+  strcpy(victim->text, text);
+  victim->font = font;
+  victim->lastUsed = textCache.clock;
+  return victim;
+}
+
+void freeTextCache(void) {
+  for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+    if (textCache.entries[i].texture)
+      SDL_DestroyTexture(textCache.entries[i].texture);
+    textCache.entries[i].texture = NULL;
+  }
+}
+
+void displayText(SDL_Renderer *renderer, TTF_Font *font, char *text, int x,
+                 int y) {
+  if (!font)
     return;
 
   SDL_Rect textRect = {x, y, 0, 0};
-  SDL_QueryTexture(texture, NULL, NULL, &textRect.w, &textRect.h);
-  SDL_RenderCopy(renderer, texture, NULL, &textRect);
-  SDL_DestroyTexture(texture);
+  if (strlen(text) >= MAX_CACHED_TEXT) {
+    SDL_Texture *texture =
+        renderText(renderer, font, text, &textRect.w, &textRect.h);
+    if (texture) {
+      SDL_RenderCopy(renderer, texture, NULL, &textRect);
+      SDL_DestroyTexture(texture);
+    }
+    return;
+  }
+
+  CachedText *cached = findCachedText(renderer, font, text);
+  if (!cached)
+    return;
+  textRect.w = cached->w;
+  textRect.h = cached->h;
+  SDL_RenderCopy(renderer, cached->texture, NULL, &textRect);
 }
 
 // edited part
-void drawQueueInfo(SDL_Renderer *renderer, TTF_Font *font) {
+void drawQueueInfo(SDL_Renderer *renderer, TTF_Font *font,
+                   const SnapshotFrame *frame) {
   if (!font)
     return;
 
   char buffer[100];
-
-  pthread_mutex_lock(&queueMutex);
-
-  int countA = getSize(queueA);
-  int countB = getSize(queueB);
-  int countC = getSize(queueC);
-  int countD = getSize(queueD);
-
-  pthread_mutex_unlock(&queueMutex);
+  const JunctionConfig *cfg = &junction->config;
+  int priorityLane = -1;
 
   // Draw semi-transparent background for info panel
   SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
   SDL_SetRenderDrawColor(renderer, 240, 240, 240, 200);
-  SDL_Rect infoPanel = {10, 10, 180, 140};
+  SDL_Rect infoPanel = {10, 10, 180, 20 + 30 * cfg->laneCount};
   SDL_RenderFillRect(renderer, &infoPanel);
 
   // Draw border
   SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
   SDL_RenderDrawRect(renderer, &infoPanel);
 
-  // Display queue counts
-  snprintf(buffer, sizeof(buffer), "Road A: %d", countA);
-  displayText(renderer, font, buffer, 20, 20);
-
-  snprintf(buffer, sizeof(buffer), "Road B: %d", countB);
-  displayText(renderer, font, buffer, 20, 50);
+  // Display queue counts from the published snapshot
+  for (int i = 0; i < cfg->laneCount; i++) {
+    const LaneConfig *lane = &cfg->lanes[i];
+    int count = frame->counts[i];
+    if (lane->priorityOn > 0 && count > lane->priorityOn && priorityLane < 0)
+      priorityLane = i;
 
-  snprintf(buffer, sizeof(buffer), "Road C: %d", countC);
-  displayText(renderer, font, buffer, 20, 80);
-
-  snprintf(buffer, sizeof(buffer), "Road D: %d", countD);
-  displayText(renderer, font, buffer, 20, 110);
+    snprintf(buffer, sizeof(buffer), "Lane %s: %d", lane->name, count);
+    displayText(renderer, font, buffer, 20, 20 + 30 * i);
+  }
 
   // Show priority status
-  if (countA > 7) {
+  if (priorityLane >= 0) {
+    int y = infoPanel.y + infoPanel.h + 10;
     SDL_SetRenderDrawColor(renderer, 255, 200, 200, 200);
-    SDL_Rect priorityIndicator = {10, 160, 180, 30};
+    SDL_Rect priorityIndicator = {10, y, 180, 30};
     SDL_RenderFillRect(renderer, &priorityIndicator);
     SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
     SDL_RenderDrawRect(renderer, &priorityIndicator);
-    displayText(renderer, font, "PRIORITY MODE", 20, 165);
+    snprintf(buffer, sizeof(buffer), "PRIORITY %s",
+             cfg->lanes[priorityLane].name);
+    displayText(renderer, font, buffer, 20, y + 5);
   }
 }
 
-void drawVehicles(SDL_Renderer *renderer) {
-  int carWidth = 20;
-  int carHeight = 20;
-  int gap = 5;
-
-  // Stop lines positions (approximate based on road width 150)
+// Top-left corner of a car 's' slots from the stop line on arm 'road'
+// (0 = A top, 1 = B bottom, 2 = C right, 3 = D left); 's' is fractional
+// while the car moves up
+void slotPosition(int road, float s, float *x, float *y) {
   int centerX = WINDOW_WIDTH / 2;
   int centerY = WINDOW_HEIGHT / 2;
   int offset = ROAD_WIDTH / 2 +
                10; // Start drawing slightly away from intersection center
 
-  pthread_mutex_lock(&queueMutex);
-
-  // Draw Road A (Top) - Queue builds upwards
-  for (int i = 0; i < getSize(queueA); i++) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue
-    int yPos = centerY - offset - (i * (carHeight + gap));
-    // Clamp to screen
-    if (yPos > -carHeight) {
-      SDL_Rect car = {centerX - 15, yPos, carWidth, carHeight};
-      SDL_RenderFillRect(renderer, &car);
-    }
+  switch (road) {
+  case 0: // Queue builds upwards
+    *x = centerX - 15;
+    *y = centerY - offset - s * CAR_PITCH;
+    break;
+  case 1: // Queue builds downwards
+    *x = centerX - 15;
+    *y = centerY + offset + s * CAR_PITCH;
+    break;
+  case 2: // Queue builds rightwards
+    *x = centerX + offset + s * CAR_PITCH;
+    *y = centerY - 15;
+    break;
+  default: // Queue builds leftwards
+    *x = centerX - offset - s * CAR_PITCH;
+    *y = centerY - 15;
+    break;
   }
+}
 
-  // Draw Road B (Bottom) - Queue builds downwards
-  for (int i = 0; i < getSize(queueB); i++) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue
-    int yPos = centerY + offset + (i * (carHeight + gap));
-    if (yPos < WINDOW_HEIGHT) {
-      SDL_Rect car = {centerX - 15, yPos, carWidth, carHeight};
-      SDL_RenderFillRect(renderer, &car);
-    }
-  }
+// Slot i of the queue on arm 'road', counted outwards from the stop line
+SDL_Rect carSlot(int road, int i) {
+  float x, y;
+  slotPosition(road, i, &x, &y);
+  return (SDL_Rect){(int)x, (int)y, CAR_SIZE, CAR_SIZE};
+}
 
-  // Draw Road C (Right) - Queue builds rightwards
-  for (int i = 0; i < getSize(queueC); i++) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue
-    int xPos = centerX + offset + (i * (carWidth + gap));
-    if (xPos < WINDOW_WIDTH) {
-      SDL_Rect car = {xPos, centerY - 15, carHeight, carWidth}; // Rotated
-      SDL_RenderFillRect(renderer, &car);
-    }
-  }
+// Slots of a queue of 'size' that are on screen; the rest are never drawn
+int visibleCars(int road, int size) {
+  int visible = 0;
+  while (visible < size && visible < MAX_VISIBLE_CARS) {
+    SDL_Rect car = carSlot(road, visible);
+    if (car.x + car.w <= 0 || car.y + car.h <= 0 || car.x >= WINDOW_WIDTH ||
+        car.y >= WINDOW_HEIGHT)
+      break;
+    visible++;
+  }
+  return visible;
+}
 
-  // Draw Road D (Left) - Queue builds leftwards
-  for (int i = 0; i < getSize(queueD); i++) {
-    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue
-    int xPos = centerX - offset - (i * (carWidth + gap));
-    if (xPos > -carWidth) {
-      SDL_Rect car = {xPos, centerY - 15, carHeight, carWidth}; // Rotated
-      SDL_RenderFillRect(renderer, &car);
-    }
+// Vehicles per road in the snapshot. The diagram has four arms, further
+// roads only appear in the info panel
+void roadSizes(const SnapshotFrame *frame, int sizes[4]) {
+  for (int i = 0; i < 4; i++)
+    sizes[i] = 0;
+  for (int i = 0; i < junction->config.roadCount && i < 4; i++) {
+    const RoadConfig *road = &junction->config.roads[i];
+    for (int l = road->firstLane; l < road->firstLane + road->laneCount; l++)
+      sizes[i] += frame->counts[l];
   }
-
-  pthread_mutex_unlock(&queueMutex);
 }
 
-void refreshLight(SDL_Renderer *renderer, SharedData *sharedData) {
-  // Always redraw lights to ensure they don't disappear on screen clear
-  // if (sharedData->nextLight == sharedData->currentLight) return;
+// Arm a car leaving 'road' from lane 'lane' drives off on, as the driver
+// sees it: lane 1 turns left, lane 3 and up turn right, lane 2 goes straight
+int exitArm(int road, int lane) {
+  static const int exits[4][3] = {
+      {2, 1, 3}, // A, heading south: C, B or D
+      {3, 0, 2}, // B, heading north: D, A or C
+      {1, 3, 0}, // C, heading west: B, D or A
+      {0, 2, 1}, // D, heading east: A, C or B
+  };
+  int turn = lane <= 1 ? 0 : lane == 2 ? 1 : 2;
+  return exits[road][turn];
+}
 
-  // Draw lights for all roads
-  for (int i = 0; i < 4; i++) {
-    bool isGreen = (sharedData->nextLight == i + 1);
-    drawLightForRoad(renderer, i, isGreen);
+// Off-screen point on the outgoing side of 'arm' where leaving cars end up
+void exitPoint(int arm, float *x, float *y) {
+  int centerX = WINDOW_WIDTH / 2;
+  int centerY = WINDOW_HEIGHT / 2;
+  switch (arm) {
+  case 0:
+    *x = centerX + 25;
+    *y = -CAR_PITCH;
+    break;
+  case 1:
+    *x = centerX - 45;
+    *y = WINDOW_HEIGHT + CAR_PITCH;
+    break;
+  case 2:
+    *x = WINDOW_WIDTH + CAR_PITCH;
+    *y = centerY + 25;
+    break;
+  default:
+    *x = -CAR_PITCH;
+    *y = centerY - 45;
+    break;
   }
-
-  sharedData->currentLight = sharedData->nextLight;
 }
-// edited part
-// edited part
-void *checkQueue(void *arg) {
-  SharedData *sharedData = (SharedData *)arg;
-
-  printf("Traffic processing thread started\n");
-
-  while (!sharedData->stopSimulation) {
-    pthread_mutex_lock(&queueMutex);
-    int countA = getSize(queueA);
-    int countB = getSize(queueB);
-    int countC = getSize(queueC);
-    int countD = getSize(queueD);
-    pthread_mutex_unlock(&queueMutex);
-
-    // 1. Check AL2 (Road A) Priority
-    if (countA > 7) { // Adjusted threshold for max capacity 10
-      printf("\n>>> PRIORITY MODE ACTIVATED: AL2 has %d vehicles (>7)\n",
-             countA);
-
-      // Switch Light to A
-      sharedData->nextLight = 1; // 1=A
-      sleep(1);                  // Transition time
-
-      while (countA >= 4 && !sharedData->stopSimulation) {
-        // Serve vehicle from A
-        pthread_mutex_lock(&queueMutex);
-        if (!isEmpty(queueA)) {
-          Vehicle *v = dequeue(queueA);
-          printf("  >> Served Priority AL2: %s (Remaining: %d)\n",
-                 v->vehicleNumber, getSize(queueA));
-          free(v);
-          countA = getSize(queueA); // Update local count
-        } else {
-          countA = 0;
-        }
-        updatePriority(lanePriorityQueue, 0, countA); // Keep UI updated
-        pthread_mutex_unlock(&queueMutex);
-
-        usleep(750000); // Simulate time per vehicle (0.75s)
-      }
-      printf("<<< PRIORITY MODE ENDED: AL2 count dropped to %d (<4)\n", countA);
 
-      sharedData->nextLight = 0; // Red
-      sleep(1);
-    }
-
-    // 2. Normal Condition
-    else {
-      // Calculate average from B, C, D
-      int average = (countB + countC + countD) / 3;
-      // Ensure at least 1 vehicle is served if queues are not empty but average
-      // is low due to integer division
-      if (average < 1)
-        average = 1;
-
-      // printf("\n--- Normal Mode (Avg Quantum: %d) ---\n", average);
-
-      // Serve each lane (A, B, C, D) in round robin
-      Queue *queues[] = {queueA, queueB, queueC, queueD};
-      // char roadIds[] = {'A', 'B', 'C', 'D'};
-
-      bool anyServed = false;
-
-      for (int i = 0; i < 4; i++) {
-        if (sharedData->stopSimulation)
-          break;
-
-        pthread_mutex_lock(&queueMutex);
-        int currentSize = getSize(queues[i]);
-        pthread_mutex_unlock(&queueMutex);
-
-        if (currentSize > 0) {
-          anyServed = true;
-          // Switch Light
-          sharedData->nextLight = i + 1; // 1=A, 2=B...
-          sleep(1);
-
-          int servedCount = 0;
-          // Serve 'average' number of vehicles or until empty
-          while (servedCount < average) {
-            pthread_mutex_lock(&queueMutex);
-            if (!isEmpty(queues[i])) {
-              Vehicle *v = dequeue(queues[i]);
-              // printf("  - Normal Served Road %c: %s\n", roadIds[i],
-              // v->vehicleNumber);
-              free(v);
-              servedCount++;
-              // Update UI priority/counts
-              updatePriority(lanePriorityQueue, i, getSize(queues[i]));
-            } else {
-              pthread_mutex_unlock(&queueMutex);
-              break;
-            }
-            pthread_mutex_unlock(&queueMutex);
-            usleep(750000); // Service rate (0.75s)
-          }
-
-          sharedData->nextLight = 0; // Red
-          sleep(1);
+// Feeds a newly read snapshot into the animation: the vehicles served since
+// the last one set off from the head of their queue towards their exit, and
+// the queues close up or grow to the new counts
+void feedCarAnimation(CarAnimation *a, const SnapshotFrame *frame) {
+  int sizes[4];
+  roadSizes(frame, sizes);
+
+  for (int r = 0; r < 4; r++) {
+    int departed = 0;
+    if (a->started && r < junction->config.roadCount) {
+      const RoadConfig *road = &junction->config.roads[r];
+      for (int l = road->firstLane; l < road->firstLane + road->laneCount;
+           l++) {
+        long n = frame->served[l] - a->served[l];
+        for (long k = 0; k < n && a->motion.departing < MOTION_MAX_DEPARTING;
+             k++) {
+          float s = departed < a->motion.queued[r]
+                        ? a->motion.slot[r][departed]
+                        : 0;
+          float x0, y0, x2, y2;
+          slotPosition(r, s, &x0, &y0);
+          exitPoint(exitArm(r, junction->config.lanes[l].laneNumber), &x2,
+                    &y2);
+          addDeparture(&a->motion, x0, y0, WINDOW_WIDTH / 2 - CAR_SIZE / 2,
+                       WINDOW_HEIGHT / 2 - CAR_SIZE / 2, x2, y2);
+          departed++;
         }
       }
-
-      // If no vehicles in any lane, just wait a bit
-      if (!anyServed) {
-        sleep(1);
-      }
     }
+
+    // Long queues are bars, which don't move; cars leaving bar mode (or on
+    // the first frame) appear in their slots
+    bool bar = sizes[r] > queueDetail;
+    int visible = bar ? 0 : visibleCars(r, sizes[r]);
+    float entry = a->started && !a->bar[r] ? MAX_VISIBLE_CARS : 0;
+    updateQueueMotion(&a->motion, r, visible, departed, entry);
+    a->bar[r] = bar;
   }
 
-  printf("Traffic processing thread stopped\n");
-  return NULL;
+  memcpy(a->served, frame->served, sizeof(long) * frame->laneCount);
+  a->started = true;
 }
 
-// file reading (edited part)
-// file reading (edited part)
-void *readAndParseFile(void *arg) {
-  (void)arg; // Suppress unused parameter warning
-  printf("File reading thread started\n");
-  printf("Monitoring file: %s\n", VEHICLE_FILE);
-
-  long lastFileSize = 0;
-
-  // Start reading from the END of the file to ignore old history
-  // This ensures queues start empty (0) and only new vehicles appear
-  FILE *initialFile = fopen(VEHICLE_FILE, "r");
-  if (initialFile) {
-    fseek(initialFile, 0, SEEK_END);
-    lastFileSize = ftell(initialFile);
-    fclose(initialFile);
-  }
-
-  // Seed random for interval variation
-  srand(time(NULL) + 1);
-
-  while (!((SharedData *)arg)->stopSimulation) {
-    // Check if file exists and has new data
-    FILE *file = fopen(VEHICLE_FILE, "r");
-    if (!file) {
-      // Check less frequently if file doesn't exist yet
-      sleep(1);
-      continue;
-    }
-
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    // If file has new data, read from last position
-    if (fileSize > lastFileSize) {
-      fseek(file, lastFileSize, SEEK_SET);
-
-      char line[MAX_LINE_LENGTH];
-      while (fgets(line, sizeof(line), file)) {
-        // Remove newline
-        line[strcspn(line, "\n")] = 0;
-
-        if (strlen(line) == 0)
-          continue;
-
-        // Parse: "VEHICLEID:LANE" -> "AA1BB234:A"
-        char *vehicleNumber = strtok(line, ":");
-        char *roadStr = strtok(NULL, ":");
-
-        if (vehicleNumber && roadStr) {
-          // Create new vehicle
-          Vehicle *v = (Vehicle *)malloc(sizeof(Vehicle));
-          if (v) {
-            strncpy(v->vehicleNumber, vehicleNumber, 9);
-            v->vehicleNumber[9] = '\0';
-            v->road = roadStr[0];
-            v->arrivalTime = time(NULL);
-
-            // Add to appropriate queue
-            pthread_mutex_lock(&queueMutex);
-            int result = -1;
-            switch (v->road) {
-            case 'A':
-              result = enqueue(queueA, v);
-              break;
-            case 'B':
-              result = enqueue(queueB, v);
-              break;
-            case 'C':
-              result = enqueue(queueC, v);
-              break;
-            case 'D':
-              result = enqueue(queueD, v);
-              break;
-            default:
-              printf("Warning: Unknown road '%c' for vehicle %s\n", v->road,
-                     v->vehicleNumber);
-              free(v);
-              v = NULL;
-            }
-            pthread_mutex_unlock(&queueMutex);
-
-            if (result == 0 && v) {
-              printf("+ Vehicle %s added to Road %c queue\n", v->vehicleNumber,
-                     v->road);
-            } else if (v) {
-              // Queue full or error
-              free(v);
-            }
-          }
-        }
-      }
-
-      lastFileSize = fileSize;
+// All cars, queued and departing, in one fill call and all queue bars in
+// another, then the bars' counts beside them
+void drawVehicles(SDL_Renderer *renderer, TTF_Font *font,
+                  const SnapshotFrame *frame, const CarAnimation *a) {
+  static SDL_FRect cars[MOTION_ARMS * MOTION_MAX_QUEUED +
+                        MOTION_MAX_DEPARTING];
+  static float x[MOTION_MAX_DEPARTING], y[MOTION_MAX_DEPARTING];
+  SDL_Rect bars[4];
+  int barRoads[4];
+  int carCount = 0, barCount = 0;
+
+  int sizes[4];
+  roadSizes(frame, sizes);
+
+  for (int r = 0; r < 4; r++) {
+    for (int k = 0; k < a->motion.queued[r]; k++) {
+      SDL_FRect *car = &cars[carCount++];
+      slotPosition(r, a->motion.slot[r][k], &car->x, &car->y);
+      car->w = CAR_SIZE;
+      car->h = CAR_SIZE;
     }
+    if (sizes[r] <= queueDetail)
+      continue;
+    int visible = visibleCars(r, sizes[r]);
+    if (visible == 0)
+      continue;
+    // The bar covers the visible slots
+    SDL_Rect first = carSlot(r, 0), last = carSlot(r, visible - 1);
+    SDL_Rect *bar = &bars[barCount];
+    bar->x = first.x < last.x ? first.x : last.x;
+    bar->y = first.y < last.y ? first.y : last.y;
+    bar->w = abs(last.x - first.x) + CAR_SIZE;
+    bar->h = abs(last.y - first.y) + CAR_SIZE;
+    barRoads[barCount++] = r;
+  }
 
-    // Check for read errors
-    if (ferror(file)) {
-      perror("Error reading vehicle file");
-      clearerr(file);
-    }
+  int departing = departurePositions(&a->motion, x, y);
+  for (int i = 0; i < departing; i++)
+    cars[carCount++] = (SDL_FRect){x[i], y[i], CAR_SIZE, CAR_SIZE};
 
-    fclose(file);
+  if (carCount > 0) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255); // Blue
+    SDL_RenderFillRectsF(renderer, cars, carCount);
+  }
+  if (barCount > 0) {
+    SDL_SetRenderDrawColor(renderer, 0, 0, 160, 255); // Dark blue
+    SDL_RenderFillRects(renderer, bars, barCount);
+  }
 
-    // 1-2 seconds interval
-    int sleepTime = 1 + rand() % 2;
-    sleep(sleepTime);
+  // Counts next to the bars, beside vertical ones and above horizontal ones
+  for (int b = 0; b < barCount; b++) {
+    char count[16];
+    SDL_Rect first = carSlot(barRoads[b], 0);
+    bool vertical = barRoads[b] < 2;
+    snprintf(count, sizeof(count), "%d", sizes[barRoads[b]]);
+    displayText(renderer, font, count, vertical ? first.x + CAR_PITCH : first.x,
+                vertical ? first.y : first.y - 30);
   }
+}
 
-  return NULL;
+void refreshLight(SDL_Renderer *renderer, const SnapshotFrame *frame) {
+  // Draw lights for all roads on the diagram
+  for (int i = 0; i < junction->config.roadCount && i < 4; i++) {
+    bool isGreen = (frame->light == i + 1);
+    drawLightForRoad(renderer, i, isGreen);
+  }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
   pthread_t tQueue, tReadFile;
   SDL_Window *window = NULL;
   SDL_Renderer *renderer = NULL;
   SDL_Event event;
+  void *(*readerThread)(void *) = readAndParseFile;
+  const char *junctionPath = NULL;
+  const char *policyName = NULL;
+  int framesPerSecond = DEFAULT_FRAME_RATE;
+  bool vsync = false;
+  bool binaryFormat = false; // only applies to the file transport
+
+  for (int i = 1; i < argc; i++) {
+    const char *value = i + 1 < argc ? argv[i + 1] : "";
+    if (strcmp(argv[i], "--junction") == 0 && i + 1 < argc) {
+      junctionPath = argv[++i];
+    } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+      policyName = argv[++i];
+    } else if (strcmp(argv[i], "--queue-detail") == 0 && i + 1 < argc) {
+      queueDetail = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+      framesPerSecond = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--vsync") == 0) {
+      vsync = true;
+    } else if (strcmp(argv[i], "--transport") == 0 &&
+               strcmp(value, "shm") == 0) {
+      readerThread = readVehicleRing;
+      i++;
+    } else if (strcmp(argv[i], "--transport") == 0 &&
+               strcmp(value, "generator") == 0) {
+      // Arrivals from the lane configs, no traffic_generator needed
+      readerThread = generateVehicles;
+      i++;
+    } else if (strcmp(argv[i], "--transport") == 0 &&
+               strcmp(value, "file") == 0) {
+      readerThread = readAndParseFile;
+      i++;
+    } else if (strcmp(argv[i], "--format") == 0 &&
+               (strcmp(value, "binary") == 0 || strcmp(value, "text") == 0)) {
+      binaryFormat = strcmp(value, "binary") == 0;
+      i++;
+    } else {
+      printf("Usage: %s [--junction FILE] [--policy NAME] "
+             "[--transport file|shm|generator] [--format text|binary] "
+             "[--queue-detail N] [--fps N] [--vsync]\n",
+             argv[0]);
+      return -1;
+    }
+  }
+  if (binaryFormat && readerThread != readAndParseFile) {
+    printf("Error: --format binary only applies to --transport file\n");
+    return -1;
+  }
+  if (binaryFormat)
+    readerThread = readVehicleLogFile;
+  if (queueDetail < 0) {
+    printf("Error: --queue-detail must not be negative\n");
+    return -1;
+  }
+  if (framesPerSecond < 1 || framesPerSecond > 1000) {
+    printf("Error: --fps must be between 1 and 1000\n");
+    return -1;
+  }
 
-  // Initialize SDL
-  if (!initializeSDL(&window, &renderer)) {
+  generatorSeed = (uint64_t)time(NULL);
+
+  JunctionConfig config;
+  int loaded = junctionPath ? loadJunctionConfig(&config, junctionPath)
+                            : loadDefaultJunctionConfig(&config);
+  if (loaded < 0)
+    return -1;
+  if (policyName && setJunctionPolicy(&config, policyName) < 0) {
+    freeJunctionConfig(&config);
     return -1;
   }
 
-  // Initialize mutex
-  pthread_mutex_init(&queueMutex, NULL);
+  // Initialize SDL
+  if (!initializeSDL(&window, &renderer, vsync)) {
+    return -1;
+  }
 
   // Initialize queues
-  queueA = createQueue();
-  queueB = createQueue();
-  queueC = createQueue();
-  queueD = createQueue();
-  lanePriorityQueue = createPriorityQueue();
-
-  if (!queueA || !queueB || !queueC || !queueD || !lanePriorityQueue) {
+  junction = createJunction(&config);
+  freeJunctionConfig(&config);
+  if (!junction) {
     printf("Error: Failed to create queues\n");
     return -1;
   }
 
   printf("=== Traffic Junction Simulator Started ===\n");
+  printf("Signal policy: %s\n", junction->config.policy);
   printf("Waiting for vehicles from traffic generator...\n\n");
 
+  // The controller publishes the lanes and light, the renderer only reads
+  // its copies of them
+  JunctionSnapshot *snapshot = createSnapshot(junction->config.laneCount);
+  SnapshotFrame frame;
+  if (!snapshot || initSnapshotFrame(&frame, junction->config.laneCount) < 0) {
+    printf("Error: Failed to create the junction snapshot\n");
+    return -1;
+  }
+
   // Shared data for light control
-  SharedData sharedData = {0, 0, false}; // Start with all lights red
+  SharedData sharedData = {0, false, junction, snapshot}; // Start all red
 
   // Load font
   TTF_Font *font = TTF_OpenFont(MAIN_FONT, 24);
@@ -787,42 +740,103 @@ int main() {
     printf("Warning: Failed to load font: %s\n", TTF_GetError());
   }
 
-  // Initial render
-  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-  SDL_RenderClear(renderer);
-  drawRoadsAndLane(renderer, font);
-  SDL_RenderPresent(renderer);
+  // Static layer, drawn once
+  SDL_Texture *background = createBackground(renderer, font);
+
+  CarAnimation cars = {.started = false};
+  initVehicleMotion(&cars.motion);
+  cars.served = calloc(junction->config.laneCount, sizeof(long));
+  if (!cars.served) {
+    printf("Error: Failed to allocate the car animation\n");
+    return -1;
+  }
 
   // Create worker threads
+  SimTime start = monotonicNs();
   pthread_create(&tQueue, NULL, checkQueue, &sharedData);
-  pthread_create(&tReadFile, NULL, readAndParseFile, &sharedData);
-
-  // Main UI thread - rendering loop
+  pthread_create(&tReadFile, NULL, readerThread, &sharedData);
+
+  // Main UI thread - rendering loop, paced by the frame clock. A frame is
+  // only drawn when the snapshot changed, cars are still moving, the frame
+  // timing shown on screen was updated or the window needs repainting
+  FrameClock frameClock;
+  initFrameClock(&frameClock, framesPerSecond);
+  char frameText[MAX_CACHED_TEXT] = "";
+  SimTime nextOverlay = monotonicNs() + FRAME_OVERLAY_INTERVAL_NS;
+  SimTime nextLog = monotonicNs() + FRAME_LOG_INTERVAL_NS;
+  unsigned long shownSequence = 0;
+  SimTime lastFrame = monotonicNs();
+  bool redraw = true;
   bool running = true;
   while (running) {
-    // Clear and redraw
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderClear(renderer);
-
-    // Draw all elements
-    drawRoadsAndLane(renderer, font);
-    drawVehicles(renderer);
-    refreshLight(renderer, &sharedData);
-    drawQueueInfo(renderer, font);
-
-    // Update display
-    SDL_RenderPresent(renderer);
+    readSnapshot(snapshot, &frame);
+    bool changed = frame.sequence != shownSequence;
+    if (changed)
+      feedCarAnimation(&cars, &frame);
+
+    // Cars move by the time since the last frame, not per snapshot
+    SimTime frameStart = monotonicNs();
+    if (advanceMotion(&cars.motion,
+                      (float)(frameStart - lastFrame) / NSEC_PER_SEC))
+      redraw = true;
+    lastFrame = frameStart;
+
+    if (changed || redraw) {
+      SimTime renderStart = monotonicNs();
+      drawBackground(renderer, background, font);
+      drawVehicles(renderer, font, &frame, &cars);
+      refreshLight(renderer, &frame);
+      drawQueueInfo(renderer, font, &frame);
+      if (frameText[0])
+        displayText(renderer, font, frameText, 10, WINDOW_HEIGHT - 35);
+      SimTime presentStart = monotonicNs();
+      SDL_RenderPresent(renderer);
+      SimTime presentEnd = monotonicNs();
+      recordLatency(&frameClock.render, presentStart - renderStart);
+      recordLatency(&frameClock.present, presentEnd - presentStart);
+      frameClock.drawn++;
+      shownSequence = frame.sequence;
+      redraw = false;
+    }
 
     // Handle events
+    SimTime eventStart = monotonicNs();
     while (SDL_PollEvent(&event)) {
       if (event.type == SDL_QUIT) {
         running = false;
         sharedData.stopSimulation = true;
+      } else if (event.type == SDL_RENDER_TARGETS_RESET) {
+        // Target texture contents are gone, draw the static layer again
+        if (background && !renderBackground(renderer, background, font)) {
+          SDL_DestroyTexture(background);
+          background = NULL;
+        }
+        redraw = true;
+      } else if (event.type == SDL_WINDOWEVENT) {
+        redraw = true;
       }
     }
+    SimTime now = monotonicNs();
+    recordLatency(&frameClock.events, now - eventStart);
+
+    if (now >= nextOverlay) {
+      snprintf(frameText, sizeof(frameText),
+               "p99 render %.1f present %.1f ms, %ld dropped",
+               latencyPercentile(&frameClock.render, 99) / 1e6,
+               latencyPercentile(&frameClock.present, 99) / 1e6,
+               frameClock.dropped);
+      nextOverlay = now + FRAME_OVERLAY_INTERVAL_NS;
+      redraw = true;
+    }
+    if (now >= nextLog) {
+      printFrameStats(stdout, &frameClock);
+      nextLog = now + FRAME_LOG_INTERVAL_NS;
+    }
 
-    SDL_Delay(16); // ~60 FPS
+    waitForFrame(&frameClock);
   }
+  if (background)
+    SDL_DestroyTexture(background);
 
   // Cleanup
   printf("\nShutting down simulator...\n");
@@ -832,14 +846,22 @@ int main() {
   pthread_join(tReadFile, NULL);
   pthread_join(tQueue, NULL);
 
-  pthread_mutex_destroy(&queueMutex);
-
-  freeQueue(queueA);
-  freeQueue(queueB);
-  freeQueue(queueC);
-  freeQueue(queueD);
-  freePriorityQueue(lanePriorityQueue);
-
+  printWaitTable(stdout, junction, monotonicNs() - start);
+  printFlowTable(stdout, junction);
+  if (junction->malformed > 0)
+    printf("Malformed vehicle records ignored: %ld\n", junction->malformed);
+  LatencySummary transport = getLatencySummary(&junction->transport);
+  printLatencyLine(stdout, "Transport (generated to read)", &transport);
+  printf("\n");
+  free(cars.served);
+  freeSnapshotFrame(&frame);
+  freeSnapshot(snapshot);
+  freeJunction(junction);
+
+  printFrameStats(stdout, &frameClock);
+  printf("Text cache: %ld hits, %ld misses\n", textCache.hits,
+         textCache.misses);
+  freeTextCache();
   if (font)
     TTF_CloseFont(font);
   if (renderer)
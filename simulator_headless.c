@@ -0,0 +1,423 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "event_sim.h"
+#include "junction.h"
+#include "network.h"
+#include "signal_control.h"
+#include "vehicle_reader.h"
+
+#define DEFAULT_SIM_DURATION_SEC 3600
+#define LIVE_REPORT_INTERVAL_SEC 5
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void handleSignal(int sig) {
+  (void)sig;
+  interrupted = 1;
+}
+
+void printUsage(const char *prog) {
+  printf("Usage: %s [--junction FILE] [--duration SECONDS] [--seed N]\n"
+         "       [--metrics FILE] [--replay FILE]\n"
+         "       [--network FILE | --grid WxH [--travel SECONDS]] "
+         "[--threads N]\n"
+         "       [--runs N [--sweep-on MIN:MAX] [--sweep-off MIN:MAX]]\n"
+         "       [--policy NAME] [--arrivals]\n"
+         "       [--live [--transport file|shm|generator] "
+         "[--format text|binary]]\n",
+         prog);
+  printf("  --junction FILE   roads and lanes to simulate (default: the "
+         "4-arm junction)\n");
+  printf("  --duration SECS   simulated time to run (default %d)\n",
+         DEFAULT_SIM_DURATION_SEC);
+  printf("  --seed N          random seed for generated arrivals\n");
+  printf("  --metrics FILE    also write per-lane metrics as CSV\n");
+  printf("  --live            follow %s in real time instead of "
+         "simulating arrivals\n",
+         VEHICLE_FILE);
+  printf("  --replay FILE     simulate the arrivals recorded in a binary log\n");
+  printf("                    (runs until all are served unless --duration)\n");
+  printf("  --arrivals        only generate each lane's arrivals for the "
+         "duration and\n"
+         "                    compare them with its mean rate (use 86400 "
+         "for profiles)\n");
+  printf("  --network FILE    simulate a network of linked junctions\n");
+  printf("  --grid WxH        simulate a W by H grid of --junction layouts\n");
+  printf("  --travel SECS     travel time between grid junctions "
+         "(default %d)\n",
+         DEFAULT_TRAVEL_SEC);
+  printf("  --threads N       worker threads for --network/--grid/--runs "
+         "(default 1)\n");
+  printf("  --runs N          run N replications per scenario and report "
+         "mean and 95%% CI\n");
+  printf("  --sweep-on A:B    with --runs: priority 'on' thresholds A..B\n");
+  printf("  --sweep-off A:B   with --runs: priority 'off' thresholds A..B\n");
+  printf("  --policy NAME     signal policy for every junction, overriding "
+         "the config:\n");
+  int nameWidth = 0;
+  for (int i = 0; i < SIGNAL_POLICY_COUNT; i++) {
+    int len = (int)strlen(SIGNAL_POLICIES[i].name);
+    if (len > nameWidth)
+      nameWidth = len;
+  }
+  for (int i = 0; i < SIGNAL_POLICY_COUNT; i++)
+    printf("                    %-*s %s\n", nameWidth,
+           SIGNAL_POLICIES[i].name, SIGNAL_POLICIES[i].summary);
+  printf("  --transport T     with --live: 'file' (default), 'shm' ring or\n"
+         "                    'generator' (in-process arrivals)\n");
+  printf("  --format F        with --live: 'text' (default) or 'binary' %s\n",
+         VEHICLE_LOG_FILE);
+}
+
+// Throughput since the last report and the waits so far, all lanes together,
+// then the transport delay from generator to reader. Served counts come from
+// the snapshot, the lane counters belong to the controller thread; the
+// histograms are relaxed atomics and may be read from here
+static void printLiveThroughput(const Junction *j, const SnapshotFrame *frame,
+                                long *lastServed, LatencyHistogram *all) {
+  long served = 0;
+  initLatencyHistogram(all);
+  for (int i = 0; i < j->config.laneCount; i++) {
+    served += frame->served[i];
+    mergeLatency(all, &j->lanes[i].wait);
+  }
+
+  LatencySummary wait = getLatencySummary(all);
+  LatencySummary transport = getLatencySummary(&j->transport);
+  printf("      served %ld (%ld/h)  ", served - *lastServed,
+         (served - *lastServed) * 3600 / LIVE_REPORT_INTERVAL_SEC);
+  printLatencyLine(stdout, "wait", &wait);
+  printf("\n      ");
+  printLatencyLine(stdout, "transport", &transport);
+  printf("\n");
+  *lastServed = served;
+}
+
+// Arrival self-check: generates every lane's arrivals for the duration in
+// bulk, without simulating the junction, and prints how many came against
+// the lane's mean rate and how fast they were generated
+static void checkArrivals(const JunctionConfig *config, long durationSec,
+                          uint64_t seed) {
+  SimTime times[4096];
+  SimTime until = durationSec * NSEC_PER_SEC;
+  Rng rng;
+  rngSeed(&rng, seed, 0);
+
+  printf("%-8s %12s %12s %12s\n", "Lane", "Arrivals", "Expected", "M/s");
+  for (int i = 0; i < config->laneCount; i++) {
+    const ArrivalSpec *spec = &config->lanes[i].arrivals;
+    ArrivalStream stream;
+    initArrivalStream(&stream, spec, &rng, 0);
+
+    size_t total = 0, n;
+    SimTime start = monotonicNs();
+    while ((n = generateArrivals(&stream, until, times, 4096)) > 0)
+      total += n;
+    double wall = (double)(monotonicNs() - start) / NSEC_PER_SEC;
+
+    printf("%-8s %12zu %12.0f %12.1f\n", config->lanes[i].name, total,
+           meanArrivalRate(spec) * durationSec / 3600,
+           wall > 0 ? total / wall / 1e6 : 0.0);
+  }
+}
+
+// Real-time mode: same threads as the SDL simulator, without a window.
+// Queue sizes, throughput and waits are printed every few seconds until the
+// duration elapses, the per-lane wait table at the end
+static int runLive(Junction *j, long durationSec,
+                   void *(*readerThread)(void *)) {
+  pthread_t tQueue, tReadFile;
+  JunctionSnapshot *snapshot = createSnapshot(j->config.laneCount);
+  SnapshotFrame frame;
+  if (!snapshot || initSnapshotFrame(&frame, j->config.laneCount) < 0) {
+    freeSnapshot(snapshot);
+    return -1;
+  }
+  SharedData sharedData = {0, false, j, snapshot};
+  long lastServed = 0;
+  LatencyHistogram *all = (LatencyHistogram *)malloc(sizeof(LatencyHistogram));
+  if (!all) {
+    printf("Error: Failed to allocate memory for wait statistics\n");
+    freeSnapshotFrame(&frame);
+    freeSnapshot(snapshot);
+    return -1;
+  }
+
+  SimTime start = monotonicNs();
+  pthread_create(&tQueue, NULL, checkQueue, &sharedData);
+  pthread_create(&tReadFile, NULL, readerThread, &sharedData);
+
+  for (long elapsed = 0; elapsed < durationSec && !interrupted; elapsed++) {
+    sleepNs(NSEC_PER_SEC);
+    if ((elapsed + 1) % LIVE_REPORT_INTERVAL_SEC == 0) {
+      // Counts and light as the controller last published them together
+      readSnapshot(snapshot, &frame);
+      printf("[%lds]", elapsed + 1);
+      for (int i = 0; i < j->config.laneCount; i++)
+        printf("  %s: %d", j->config.lanes[i].name, frame.counts[i]);
+      printf("  light: %d\n", frame.light);
+      printLiveThroughput(j, &frame, &lastServed, all);
+    }
+  }
+
+  sharedData.stopSimulation = true;
+  pthread_join(tReadFile, NULL);
+  pthread_join(tQueue, NULL);
+
+  printWaitTable(stdout, j, monotonicNs() - start);
+  printFlowTable(stdout, j);
+  if (j->malformed > 0)
+    printf("Malformed vehicle records ignored: %ld\n", j->malformed);
+  LatencySummary transport = getLatencySummary(&j->transport);
+  printLatencyLine(stdout, "Transport (generated to read)", &transport);
+  printf("\n");
+  VehiclePoolStats poolStats = getPoolStats(j->pool);
+  printPoolStats(stdout, &poolStats);
+  free(all);
+  freeSnapshotFrame(&frame);
+  freeSnapshot(snapshot);
+  return 0;
+}
+
+// Network mode: every junction of the network in one simulated clock
+static int runNetwork(Network *n, long durationSec, uint64_t seed,
+                      int threads, const char *metricsPath,
+                      const char *policyName) {
+  SimConfig cfg = {durationSec * NSEC_PER_SEC, seed, NULL, 0};
+  NetworkStats stats;
+
+  for (int i = 0; policyName && i < n->nodeCount; i++) {
+    if (setJunctionPolicy(&n->nodes[i].junction->config, policyName) < 0)
+      return -1;
+  }
+
+  int result = runNetworkSimulation(n, &cfg, threads, &stats);
+  if (result == 0) {
+    printNetworkStats(stdout, n, &stats);
+    if (metricsPath)
+      result = writeNetworkStatsCsv(metricsPath, n);
+  }
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  long durationSec = DEFAULT_SIM_DURATION_SEC;
+  uint64_t seed = (uint64_t)time(NULL);
+  const char *metricsPath = NULL;
+  const char *replayPath = NULL;
+  const char *junctionPath = NULL;
+  const char *networkPath = NULL;
+  const char *policyName = NULL;
+  int gridWidth = 0, gridHeight = 0;
+  double travelSec = DEFAULT_TRAVEL_SEC;
+  int threads = 1;
+  int runs = 0;
+  int onMin = 0, onMax = 0, offMin = 0, offMax = 0;
+  bool durationGiven = false;
+  bool live = false;
+  bool arrivalsOnly = false;
+  void *(*readerThread)(void *) = readAndParseFile;
+  bool fileTransport = true; // --format only applies to the file transport
+  bool binaryFormat = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+      char *end;
+      durationSec = strtol(argv[++i], &end, 10);
+      if (end == argv[i] || *end != '\0') {
+        printUsage(argv[0]);
+        return 1;
+      }
+      durationGiven = true;
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+      metricsPath = argv[++i];
+    } else if (strcmp(argv[i], "--live") == 0) {
+      live = true;
+    } else if (strcmp(argv[i], "--arrivals") == 0) {
+      arrivalsOnly = true;
+    } else if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+      const char *transport = argv[++i];
+      fileTransport = strcmp(transport, "file") == 0;
+      if (fileTransport) {
+        readerThread = readAndParseFile;
+      } else if (strcmp(transport, "shm") == 0) {
+        readerThread = readVehicleRing;
+      } else if (strcmp(transport, "generator") == 0) {
+        readerThread = generateVehicles;
+      } else {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      const char *format = argv[++i];
+      binaryFormat = strcmp(format, "binary") == 0;
+      if (!binaryFormat && strcmp(format, "text") != 0) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (strcmp(argv[i], "--junction") == 0 && i + 1 < argc) {
+      junctionPath = argv[++i];
+    } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+      policyName = argv[++i];
+    } else if (strcmp(argv[i], "--network") == 0 && i + 1 < argc) {
+      networkPath = argv[++i];
+    } else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &gridWidth, &gridHeight) != 2) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--travel") == 0 && i + 1 < argc) {
+      travelSec = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--sweep-on") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%d:%d", &onMin, &onMax) != 2) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--sweep-off") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%d:%d", &offMin, &offMax) != 2) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  // Batches replicate one junction with generated arrivals
+  if (runs > 0 && (gridWidth > 0 || networkPath || replayPath || live)) {
+    printf("Error: --runs cannot be combined with --grid, --network, "
+           "--replay or --live\n");
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (binaryFormat && !fileTransport) {
+    printf("Error: --format binary only applies to --transport file\n");
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (binaryFormat)
+    readerThread = readVehicleLogFile;
+
+  // Only a replay without --duration runs until drained, anything else
+  // needs an end
+  if (durationSec <= 0) {
+    printf("Error: --duration must be positive\n");
+    return 1;
+  }
+
+  // Printed so any run can be reproduced with --seed
+  generatorSeed = seed;
+  if (!live)
+    printf("Seed: %llu\n", (unsigned long long)seed);
+
+  if (networkPath) {
+    Network *n = loadNetwork(networkPath);
+    if (!n)
+      return 1;
+    int result = runNetwork(n, durationSec, seed, threads, metricsPath,
+                            policyName);
+    freeNetwork(n);
+    return result == 0 ? 0 : 1;
+  }
+
+  JunctionConfig config;
+  int loaded = junctionPath ? loadJunctionConfig(&config, junctionPath)
+                            : loadDefaultJunctionConfig(&config);
+  if (loaded < 0)
+    return 1;
+  if (policyName && setJunctionPolicy(&config, policyName) < 0) {
+    freeJunctionConfig(&config);
+    return 1;
+  }
+
+  if (arrivalsOnly) {
+    checkArrivals(&config, durationSec, seed);
+    freeJunctionConfig(&config);
+    return 0;
+  }
+
+  if (runs > 0) {
+    BatchConfig batch = {&config, durationSec * NSEC_PER_SEC, seed, runs,
+                         threads, onMin, onMax, offMin, offMax};
+    BatchResult result;
+    int failed = runBatch(&batch, &result);
+    freeJunctionConfig(&config);
+    if (failed == 0) {
+      printBatchResult(stdout, &result);
+      if (metricsPath)
+        failed = writeBatchCsv(metricsPath, &result);
+    }
+    freeBatchResult(&result);
+    return failed == 0 ? 0 : 1;
+  }
+
+  if (gridWidth > 0) {
+    Network *n = createGridNetwork(gridWidth, gridHeight, &config,
+                                   (SimTime)(travelSec * NSEC_PER_SEC));
+    freeJunctionConfig(&config);
+    if (!n)
+      return 1;
+    int result = runNetwork(n, durationSec, seed, threads, metricsPath,
+                            policyName);
+    freeNetwork(n);
+    return result == 0 ? 0 : 1;
+  }
+
+  Junction *j = createJunction(&config);
+  freeJunctionConfig(&config);
+  if (!j) {
+    printf("Error: Failed to create queues\n");
+    return 1;
+  }
+
+  signal(SIGINT, handleSignal);
+  signal(SIGTERM, handleSignal);
+
+  int result;
+  if (live) {
+    result = runLive(j, durationSec, readerThread);
+  } else {
+    SimConfig cfg = {durationSec * NSEC_PER_SEC, seed, NULL, 0};
+    VehicleLog replay;
+    SimStats stats;
+
+    if (replayPath) {
+      if (mapVehicleLog(&replay, replayPath) != 0) {
+        printf("Error: Cannot read vehicle log %s\n", replayPath);
+        freeJunction(j);
+        return 1;
+      }
+      printf("Replaying %zu vehicles from %s\n", replay.count, replayPath);
+      cfg.replay = &replay;
+      if (!durationGiven)
+        cfg.duration = 0; // until every recorded vehicle is served
+    }
+
+    result = runEventSimulation(j, &cfg, &stats);
+    if (replayPath)
+      unmapVehicleLog(&replay);
+    if (result == 0) {
+      printSimStats(stdout, j, &stats);
+      if (metricsPath)
+        result = writeSimStatsCsv(metricsPath, j, &stats);
+    }
+  }
+
+  freeJunction(j);
+  return result == 0 ? 0 : 1;
+}
@@ -1,3 +1,4 @@
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -5,41 +6,142 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "rng.h"
+#include "sim_time.h"
+#include "vehicle_log.h"
+#include "vehicle_ring.h"
+
 #define FILENAME "vehicles.data"
 #define MIN_SLEEP_SEC 1
 #define MAX_SLEEP_SEC 2
 
+static volatile sig_atomic_t interrupted = 0;
+
+static void handleSignal(int sig) {
+  (void)sig;
+  interrupted = 1;
+}
+
 // Function to generate a random vehicle number
 // Format: 2 letters + 1 digit + 2 letters + 3 digits (e.g., AA1BB234)
-void generateVehicleNumber(char *buffer) {
-  buffer[0] = 'A' + rand() % 26;
-  buffer[1] = 'A' + rand() % 26;
-  buffer[2] = '0' + rand() % 10;
-  buffer[3] = 'A' + rand() % 26;
-  buffer[4] = 'A' + rand() % 26;
-  buffer[5] = '0' + rand() % 10;
-  buffer[6] = '0' + rand() % 10;
-  buffer[7] = '0' + rand() % 10;
+void generateVehicleNumber(char *buffer, Rng *rng) {
+  buffer[0] = 'A' + rngBelow(rng, 26);
+  buffer[1] = 'A' + rngBelow(rng, 26);
+  buffer[2] = '0' + rngBelow(rng, 10);
+  buffer[3] = 'A' + rngBelow(rng, 26);
+  buffer[4] = 'A' + rngBelow(rng, 26);
+  buffer[5] = '0' + rngBelow(rng, 10);
+  buffer[6] = '0' + rngBelow(rng, 10);
+  buffer[7] = '0' + rngBelow(rng, 10);
   buffer[8] = '\0';
 }
 
 // Function to generate a random lane
-char generateLane() {
+char generateLane(Rng *rng) {
   char lanes[] = {'A', 'B', 'C', 'D'};
-  return lanes[rand() % 4];
+  return lanes[rngBelow(rng, 4)];
+}
+
+// Appends one vehicle as a "VEHICLEID:ROAD:0:GENERATED_NS" line to the data
+// file. Lane 0 is the road's first lane; the timestamp is CLOCK_MONOTONIC, the
+// same clock the simulator reads, so it can measure the transport delay
+bool writeToFile(const char *vehicle, char lane) {
+  SimTime generatedAt = monotonicNs();
+  FILE *file = fopen(FILENAME, "a");
+  if (!file) {
+    perror("Error opening file");
+    return false;
+  }
+  fprintf(file, "%s:%c:0:%lld\n", vehicle, lane, (long long)generatedAt);
+  fflush(file);
+  fclose(file);
+  return true;
+}
+
+static void fillRecord(VehicleRecord *rec, const char *vehicle, char lane) {
+  memset(rec, 0, sizeof(*rec));
+  memcpy(rec->plate, vehicle, PLATE_LENGTH);
+  rec->road = lane;
+  rec->timestampNs = monotonicNs();
 }
 
-int main() {
-  srand(time(NULL)); // Initialize random seed
+// Appends one fixed-size record to the binary log, which stays open
+bool writeToLog(VehicleLogWriter *log, const char *vehicle, char lane) {
+  VehicleRecord rec;
+  fillRecord(&rec, vehicle, lane);
+  return appendVehicleLog(log, &rec) == 0;
+}
+
+// Pushes one vehicle into the shared-memory ring, no syscalls involved
+bool writeToRing(VehicleRing *ring, const char *vehicle, char lane) {
+  VehicleRecord rec;
+  fillRecord(&rec, vehicle, lane);
 
-  // Clear file initially
-  FILE *file = fopen(FILENAME, "w");
-  if (file) {
-    fclose(file);
-    printf("Initialized %s\n", FILENAME);
+  if (!ringPush(ring, &rec)) {
+    printf("Warning: Ring full (simulator not running?), dropped %s:%c\n",
+           vehicle, lane);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  bool useRing = false;
+  bool binary = false;
+  VehicleRing ring;
+  VehicleLogWriter log;
+  uint64_t seed = (uint64_t)time(NULL);
+  Rng rng;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+      const char *transport = argv[++i];
+      if (strcmp(transport, "shm") == 0) {
+        useRing = true;
+      } else if (strcmp(transport, "file") != 0) {
+        printf("Unknown transport '%s' (expected file or shm)\n", transport);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      const char *format = argv[++i];
+      if (strcmp(format, "binary") == 0) {
+        binary = true;
+      } else if (strcmp(format, "text") != 0) {
+        printf("Unknown format '%s' (expected text or binary)\n", format);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else {
+      printf("Usage: %s [--transport file|shm] [--format text|binary] "
+             "[--seed N]\n",
+             argv[0]);
+      return 1;
+    }
+  }
+
+  // Own generator stream; the seed is printed so a run can be repeated
+  rngSeed(&rng, seed, 0);
+  printf("Seed: %llu\n", (unsigned long long)seed);
+
+  if (useRing) {
+    if (openVehicleRing(&ring, VEHICLE_RING_NAME) < 0)
+      return 1;
+    printf("Writing to shared memory ring %s\n", VEHICLE_RING_NAME);
+  } else if (binary) {
+    if (openVehicleLogWriter(&log, VEHICLE_LOG_FILE) < 0)
+      return 1;
+    printf("Initialized %s\n", VEHICLE_LOG_FILE);
   } else {
-    perror("Error initializing file");
-    return 1;
+    // Clear file initially
+    FILE *file = fopen(FILENAME, "w");
+    if (file) {
+      fclose(file);
+      printf("Initialized %s\n", FILENAME);
+    } else {
+      perror("Error initializing file");
+      return 1;
+    }
   }
 
   printf("Starting Traffic Generator...\n");
@@ -49,16 +151,18 @@ int main() {
   printf("  Road C: Every 3-5s (Slow)\n");
   printf("  Road D: Every 4-6s (Very Slow)\n");
   printf("Press Ctrl+C to stop.\n\n");
+  signal(SIGINT, handleSignal);
+  signal(SIGTERM, handleSignal);
 
   // Track next generation time for each lane
   time_t nextTime[4];
   time_t now = time(NULL);
 
   for (int i = 0; i < 4; i++) {
-    nextTime[i] = now + (rand() % 3); // Stagger start times
+    nextTime[i] = now + rngBelow(&rng, 3); // Stagger start times
   }
 
-  while (1) {
+  while (!interrupted) {
     now = time(NULL);
     bool generated = false;
 
@@ -67,20 +171,16 @@ int main() {
       if (now >= nextTime[i]) {
         // Generate for this lane
         char vehicle[9];
-        generateVehicleNumber(vehicle);
+        generateVehicleNumber(vehicle, &rng);
         char laneIds[] = {'A', 'B', 'C', 'D'};
         char lane = laneIds[i];
 
-        // Append to file
-        file = fopen(FILENAME, "a");
-        if (file) {
-          fprintf(file, "%s:%c\n", vehicle, lane);
-          fflush(file);
-          fclose(file);
+        bool written = useRing  ? writeToRing(&ring, vehicle, lane)
+                       : binary ? writeToLog(&log, vehicle, lane)
+                                : writeToFile(vehicle, lane);
+        if (written) {
           printf("Generated: %s:%c\n", vehicle, lane);
           generated = true;
-        } else {
-          perror("Error opening file");
         }
 
         // Set next time based on specific lane rates
@@ -91,13 +191,13 @@ int main() {
           interval = 1;
           break; // 1s (Very Fast)
         case 'B':
-          interval = 1 + rand() % 2;
+          interval = 1 + rngBelow(&rng, 2);
           break; // 1-2s
         case 'C':
-          interval = 1 + rand() % 3;
+          interval = 1 + rngBelow(&rng, 3);
           break; // 1-3s
         case 'D':
-          interval = 2 + rand() % 2;
+          interval = 2 + rngBelow(&rng, 2);
           break; // 2-3s
         }
         nextTime[i] = now + interval;
@@ -109,5 +209,15 @@ int main() {
     }
   }
 
+  // The ring's name goes with the generator. An attached simulator sees it
+  // closed and moves on to the segment of the next run
+  printf("\nStopping Traffic Generator...\n");
+  if (useRing) {
+    markVehicleRingClosed(&ring);
+    closeVehicleRing(&ring);
+    unlinkVehicleRing(VEHICLE_RING_NAME);
+  } else if (binary) {
+    closeVehicleLogWriter(&log);
+  }
   return 0;
 }
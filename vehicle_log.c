@@ -0,0 +1,134 @@
+#include "vehicle_log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sim_time.h"
+
+int openVehicleLogWriter(VehicleLogWriter *w, const char *path) {
+  w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  if (w->fd < 0) {
+    perror("Error opening vehicle log");
+    return -1;
+  }
+
+  VehicleLogHeader header = {0};
+  memcpy(header.magic, VEHICLE_LOG_MAGIC, sizeof(header.magic));
+  header.version = VEHICLE_LOG_VERSION;
+  header.recordSize = sizeof(VehicleRecord);
+  header.createdNs = monotonicNs();
+
+  if (write(w->fd, &header, sizeof(header)) != sizeof(header)) {
+    perror("Error writing vehicle log header");
+    close(w->fd);
+    w->fd = -1;
+    return -1;
+  }
+  return 0;
+}
+
+// A single write() per record keeps appends whole for concurrent readers
+int appendVehicleLog(VehicleLogWriter *w, const VehicleRecord *rec) {
+  ssize_t n;
+  do {
+    n = write(w->fd, rec, sizeof(*rec));
+  } while (n < 0 && errno == EINTR);
+
+  if (n != sizeof(*rec)) {
+    perror("Error writing vehicle log");
+    return -1;
+  }
+  return 0;
+}
+
+void closeVehicleLogWriter(VehicleLogWriter *w) {
+  if (w->fd >= 0)
+    close(w->fd);
+  w->fd = -1;
+}
+
+// Maps the current file size, keeping the descriptor for later refreshes
+static int mapCurrentSize(VehicleLog *log) {
+  struct stat st;
+  if (fstat(log->fd, &st) < 0)
+    return -1;
+  if ((size_t)st.st_size < sizeof(VehicleLogHeader))
+    return 1;
+
+  void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, log->fd, 0);
+  if (base == MAP_FAILED) {
+    perror("Error mapping vehicle log");
+    return -1;
+  }
+
+  const VehicleLogHeader *header = (const VehicleLogHeader *)base;
+  if (memcmp(header->magic, VEHICLE_LOG_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != VEHICLE_LOG_VERSION ||
+      header->recordSize != sizeof(VehicleRecord)) {
+    printf("Error: Not a version %d vehicle log\n", VEHICLE_LOG_VERSION);
+    munmap(base, st.st_size);
+    return -1;
+  }
+
+  log->base = base;
+  log->mapSize = st.st_size;
+  log->header = header;
+  log->records = (const VehicleRecord *)(header + 1);
+  log->count = (st.st_size - sizeof(VehicleLogHeader)) / sizeof(VehicleRecord);
+  return 0;
+}
+
+int mapVehicleLog(VehicleLog *log, const char *path) {
+  memset(log, 0, sizeof(*log));
+  log->fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (log->fd < 0)
+    return errno == ENOENT ? 1 : -1;
+
+  int result = mapCurrentSize(log);
+  if (result != 0) {
+    close(log->fd);
+    log->fd = -1;
+  }
+  return result;
+}
+
+size_t refreshVehicleLog(VehicleLog *log) {
+  struct stat st;
+  size_t previous = log->count;
+  int64_t createdNs = log->header ? log->header->createdNs : 0;
+
+  if (fstat(log->fd, &st) < 0 || (size_t)st.st_size == log->mapSize)
+    return previous;
+
+  // Shrunk below what we already consumed: the writer started a new log
+  if ((size_t)st.st_size < log->mapSize)
+    previous = 0;
+
+  if (log->base)
+    munmap(log->base, log->mapSize);
+  log->base = NULL;
+  log->header = NULL;
+  log->mapSize = 0;
+  log->count = 0;
+  if (mapCurrentSize(log) != 0)
+    return 0;
+
+  // Truncated and refilled past the old size between two refreshes
+  if (createdNs != 0 && log->header->createdNs != createdNs)
+    previous = 0;
+  return previous;
+}
+
+void unmapVehicleLog(VehicleLog *log) {
+  if (log->base)
+    munmap(log->base, log->mapSize);
+  if (log->fd >= 0)
+    close(log->fd);
+  memset(log, 0, sizeof(*log));
+  log->fd = -1;
+}
@@ -0,0 +1,54 @@
+#ifndef VEHICLE_LOG_H
+#define VEHICLE_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vehicle_record.h"
+
+#define VEHICLE_LOG_FILE "vehicles.bin"
+#define VEHICLE_LOG_MAGIC "DSAVEHLG"
+#define VEHICLE_LOG_VERSION 1
+
+// Binary vehicle log: this header followed by back-to-back VehicleRecords
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize; // sizeof(VehicleRecord) of the writer
+  int64_t createdNs;   // CLOCK_MONOTONIC time the log was started
+} VehicleLogHeader;
+
+_Static_assert(sizeof(VehicleLogHeader) == 24, "header must stay 24 bytes");
+
+// Writer keeps the file open, one write() per record
+typedef struct {
+  int fd;
+} VehicleLogWriter;
+
+// Read-only mapping of a log. Records are used in place, never copied
+typedef struct {
+  int fd;
+  void *base;
+  size_t mapSize;
+  const VehicleLogHeader *header;
+  const VehicleRecord *records;
+  size_t count; // complete records currently mapped
+} VehicleLog;
+
+// Truncates the file and writes a fresh header. Returns 0 on success
+int openVehicleLogWriter(VehicleLogWriter *w, const char *path);
+int appendVehicleLog(VehicleLogWriter *w, const VehicleRecord *rec);
+void closeVehicleLogWriter(VehicleLogWriter *w);
+
+// Maps the whole file and validates the header. Returns 0 on success, 1 if
+// the file is missing or does not have a complete header yet, -1 on error
+int mapVehicleLog(VehicleLog *log, const char *path);
+
+// Picks up records appended since the last (re)map. Returns the previous
+// record count, or 0 if the file was truncated and must be read from start
+size_t refreshVehicleLog(VehicleLog *log);
+
+void unmapVehicleLog(VehicleLog *log);
+
+#endif
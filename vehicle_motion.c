@@ -0,0 +1,88 @@
+#include "vehicle_motion.h"
+
+#include <string.h>
+
+void initVehicleMotion(VehicleMotion *m) {
+  memset(m, 0, sizeof(*m));
+}
+
+void updateQueueMotion(VehicleMotion *m, int arm, int visible, int departed,
+                       float entrySlot) {
+  float *slot = m->slot[arm];
+  int queued = m->queued[arm];
+
+  // Departed cars leave the head, the rest keep their positions and so
+  // close up towards their new slots
+  if (departed > queued)
+    departed = queued;
+  memmove(slot, slot + departed, sizeof(float) * (queued - departed));
+  queued -= departed;
+
+  if (visible > MOTION_MAX_QUEUED)
+    visible = MOTION_MAX_QUEUED;
+  for (int k = queued; k < visible; k++) {
+    float behind = k > 0 ? slot[k - 1] + 1 : 0;
+    slot[k] = behind > entrySlot ? behind : entrySlot;
+    if (slot[k] < k)
+      slot[k] = k;
+  }
+  m->queued[arm] = visible;
+}
+
+void addDeparture(VehicleMotion *m, float x0, float y0, float x1, float y1,
+                  float x2, float y2) {
+  if (m->departing >= MOTION_MAX_DEPARTING)
+    return;
+  int i = m->departing++;
+  m->x0[i] = x0;
+  m->y0[i] = y0;
+  m->x1[i] = x1;
+  m->y1[i] = y1;
+  m->x2[i] = x2;
+  m->y2[i] = y2;
+  m->t[i] = 0;
+}
+
+bool advanceMotion(VehicleMotion *m, float seconds) {
+  bool moving = false;
+
+  float step = QUEUE_SLOTS_PER_SEC * seconds;
+  for (int arm = 0; arm < MOTION_ARMS; arm++) {
+    float *slot = m->slot[arm];
+    for (int k = 0; k < m->queued[arm]; k++) {
+      if (slot[k] > k) {
+        slot[k] = slot[k] - step > k ? slot[k] - step : k;
+        moving = true;
+      }
+    }
+  }
+
+  // Finished cars are replaced by the last one, order doesn't matter
+  float dt = seconds / DEPARTURE_SEC;
+  for (int i = 0; i < m->departing;) {
+    m->t[i] += dt;
+    if (m->t[i] < 1) {
+      i++;
+      continue;
+    }
+    int last = --m->departing;
+    m->x0[i] = m->x0[last];
+    m->y0[i] = m->y0[last];
+    m->x1[i] = m->x1[last];
+    m->y1[i] = m->y1[last];
+    m->x2[i] = m->x2[last];
+    m->y2[i] = m->y2[last];
+    m->t[i] = m->t[last];
+  }
+  return moving || m->departing > 0;
+}
+
+int departurePositions(const VehicleMotion *m, float *x, float *y) {
+  for (int i = 0; i < m->departing; i++) {
+    float t = m->t[i], u = 1 - t;
+    float a = u * u, b = 2 * u * t, c = t * t;
+    x[i] = a * m->x0[i] + b * m->x1[i] + c * m->x2[i];
+    y[i] = a * m->y0[i] + b * m->y1[i] + c * m->y2[i];
+  }
+  return m->departing;
+}
@@ -0,0 +1,48 @@
+#ifndef VEHICLE_MOTION_H
+#define VEHICLE_MOTION_H
+
+#include <stdbool.h>
+
+#define MOTION_ARMS 4            // arms of the junction diagram
+#define MOTION_MAX_QUEUED 32     // animated cars per arm
+#define MOTION_MAX_DEPARTING 128 // cars crossing the junction at once
+#define QUEUE_SLOTS_PER_SEC 8.0f // how fast a queue closes up
+#define DEPARTURE_SEC 1.2f       // time to cross the junction and leave
+
+// Renderer-side motion of the cars in the diagram, advanced by frame time
+// so they glide between the snapshots the controller publishes. Queued cars
+// are kept per arm as a position in slots from the stop line (0 = head,
+// fractional while moving up); departing cars follow a quadratic Bezier
+// from their slot through the junction to their exit, stored as separate
+// arrays so a frame computes all positions in one pass. UI thread only
+typedef struct {
+  int queued[MOTION_ARMS];
+  float slot[MOTION_ARMS][MOTION_MAX_QUEUED];
+
+  int departing;
+  float x0[MOTION_MAX_DEPARTING], y0[MOTION_MAX_DEPARTING];
+  float x1[MOTION_MAX_DEPARTING], y1[MOTION_MAX_DEPARTING];
+  float x2[MOTION_MAX_DEPARTING], y2[MOTION_MAX_DEPARTING];
+  float t[MOTION_MAX_DEPARTING]; // 0..1 along the path
+} VehicleMotion;
+
+void initVehicleMotion(VehicleMotion *m);
+
+// The queue on 'arm' lost 'departed' cars from its head and now shows
+// 'visible' cars. Newly visible cars drive in from 'entrySlot' (or just
+// behind the car ahead of them); 0 puts them straight into their slots
+void updateQueueMotion(VehicleMotion *m, int arm, int visible, int departed,
+                       float entrySlot);
+
+// A car leaves from (x0, y0) via (x1, y1) to (x2, y2). Dropped if
+// MOTION_MAX_DEPARTING cars are already on their way
+void addDeparture(VehicleMotion *m, float x0, float y0, float x1, float y1,
+                  float x2, float y2);
+
+// Moves every car on by 'seconds'. Returns true while any car still moves
+bool advanceMotion(VehicleMotion *m, float seconds);
+
+// Current positions of the departing cars into x and y, returns how many
+int departurePositions(const VehicleMotion *m, float *x, float *y);
+
+#endif
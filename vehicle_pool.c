@@ -0,0 +1,129 @@
+#include "vehicle_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+VehiclePool *createVehiclePool() {
+  VehiclePool *pool = (VehiclePool *)calloc(1, sizeof(VehiclePool));
+  if (!pool) {
+    printf("Error: Failed to allocate memory for vehicle pool\n");
+    return NULL;
+  }
+  pool->freeList = NO_VEHICLE;
+  atomic_init(&pool->returned, NO_VEHICLE);
+  return pool;
+}
+
+// Adds one slab and threads all its slots onto the private free list
+static int addSlab(VehiclePool *pool) {
+  long count = atomic_load_explicit(&pool->slabCount, memory_order_relaxed);
+  if (count == VEHICLE_MAX_SLABS) {
+    printf("Error: Vehicle pool is full (%d vehicles)\n",
+           VEHICLE_MAX_SLABS * VEHICLE_SLAB_SIZE);
+    return -1;
+  }
+  VehicleSlab *slab = (VehicleSlab *)malloc(sizeof(VehicleSlab));
+  if (!slab) {
+    printf("Error: Failed to allocate vehicle slab\n");
+    return -1;
+  }
+
+  VehicleId first = (VehicleId)count << VEHICLE_SLAB_SHIFT;
+  for (int i = 0; i < VEHICLE_SLAB_SIZE - 1; i++)
+    slab->nextFree[i] = first + i + 1;
+  slab->nextFree[VEHICLE_SLAB_SIZE - 1] = pool->freeList;
+  pool->freeList = first;
+
+  pool->slabs[count] = slab;
+  atomic_store_explicit(&pool->slabCount, count + 1, memory_order_relaxed);
+  return 0;
+}
+
+VehicleId poolAlloc(VehiclePool *pool) {
+  if (!pool)
+    return NO_VEHICLE;
+
+  // Take everything freed since last time before growing
+  if (pool->freeList == NO_VEHICLE)
+    pool->freeList = atomic_exchange_explicit(&pool->returned, NO_VEHICLE,
+                                              memory_order_acquire);
+  if (pool->freeList == NO_VEHICLE && addSlab(pool) < 0)
+    return NO_VEHICLE;
+
+  VehicleId id = pool->freeList;
+  pool->freeList = VEHICLE_FIELD(pool, id, nextFree);
+
+  long allocations =
+      atomic_fetch_add_explicit(&pool->allocations, 1, memory_order_relaxed) +
+      1;
+  long inUse =
+      allocations - atomic_load_explicit(&pool->frees, memory_order_relaxed);
+  if (inUse > atomic_load_explicit(&pool->peakInUse, memory_order_relaxed))
+    atomic_store_explicit(&pool->peakInUse, inUse, memory_order_relaxed);
+
+  return id;
+}
+
+void poolFree(VehiclePool *pool, VehicleId id) {
+  if (!pool || id == NO_VEHICLE)
+    return;
+
+  // Push only, the allocator pops the whole stack at once, so no ABA
+  VehicleId *next = &VEHICLE_FIELD(pool, id, nextFree);
+  *next = atomic_load_explicit(&pool->returned, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&pool->returned, next, id,
+                                                memory_order_release,
+                                                memory_order_relaxed))
+    ;
+  atomic_fetch_add_explicit(&pool->frees, 1, memory_order_relaxed);
+}
+
+void loadVehicle(const VehiclePool *pool, VehicleId id, Vehicle *v) {
+  memcpy(v->vehicleNumber, VEHICLE_FIELD(pool, id, vehicleNumber),
+         sizeof(v->vehicleNumber));
+  v->road = VEHICLE_FIELD(pool, id, road);
+  v->lane = VEHICLE_FIELD(pool, id, lane);
+  v->generatedAt = VEHICLE_FIELD(pool, id, generatedAt);
+  v->ingestedAt = VEHICLE_FIELD(pool, id, ingestedAt);
+  v->queuedAt = VEHICLE_FIELD(pool, id, queuedAt);
+  v->servedAt = VEHICLE_FIELD(pool, id, servedAt);
+}
+
+void storeVehicle(VehiclePool *pool, VehicleId id, const Vehicle *v) {
+  memcpy(VEHICLE_FIELD(pool, id, vehicleNumber), v->vehicleNumber,
+         sizeof(v->vehicleNumber));
+  VEHICLE_FIELD(pool, id, road) = v->road;
+  VEHICLE_FIELD(pool, id, lane) = v->lane;
+  VEHICLE_FIELD(pool, id, generatedAt) = v->generatedAt;
+  VEHICLE_FIELD(pool, id, ingestedAt) = v->ingestedAt;
+  VEHICLE_FIELD(pool, id, queuedAt) = v->queuedAt;
+  VEHICLE_FIELD(pool, id, servedAt) = v->servedAt;
+}
+
+VehiclePoolStats getPoolStats(VehiclePool *pool) {
+  VehiclePoolStats stats;
+  stats.slabs = atomic_load(&pool->slabCount);
+  stats.capacity = stats.slabs * VEHICLE_SLAB_SIZE;
+  stats.allocations = atomic_load(&pool->allocations);
+  stats.inUse = stats.allocations - atomic_load(&pool->frees);
+  stats.peakInUse = atomic_load(&pool->peakInUse);
+  return stats;
+}
+
+void printPoolStats(FILE *out, const VehiclePoolStats *s) {
+  fprintf(out,
+          "Vehicle pool: %ld in use (peak %ld) of %ld slots in %ld slabs, "
+          "%ld allocations\n",
+          s->inUse, s->peakInUse, s->capacity, s->slabs, s->allocations);
+}
+
+void freeVehiclePool(VehiclePool *pool) {
+  if (!pool)
+    return;
+
+  long slabs = atomic_load(&pool->slabCount);
+  for (long i = 0; i < slabs; i++)
+    free(pool->slabs[i]);
+  free(pool);
+}
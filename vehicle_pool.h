@@ -0,0 +1,72 @@
+#ifndef VEHICLE_POOL_H
+#define VEHICLE_POOL_H
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "queue.h"
+
+#define VEHICLE_SLAB_SHIFT 10 // 1024 vehicles per slab
+#define VEHICLE_SLAB_SIZE (1 << VEHICLE_SLAB_SHIFT)
+#define VEHICLE_SLAB_MASK (VEHICLE_SLAB_SIZE - 1)
+#define VEHICLE_MAX_SLABS 4096 // up to 4M vehicles in use at once
+
+// One slab of vehicles, each field in its own array so a pass over one
+// field streams through memory. 'nextFree' links free slots, apart from the
+// fields so a freed vehicle stays readable until it is allocated again
+typedef struct {
+  char vehicleNumber[VEHICLE_SLAB_SIZE][10];
+  char road[VEHICLE_SLAB_SIZE];
+  unsigned char lane[VEHICLE_SLAB_SIZE];
+  SimTime generatedAt[VEHICLE_SLAB_SIZE];
+  SimTime ingestedAt[VEHICLE_SLAB_SIZE];
+  SimTime queuedAt[VEHICLE_SLAB_SIZE];
+  SimTime servedAt[VEHICLE_SLAB_SIZE];
+  VehicleId nextFree[VEHICLE_SLAB_SIZE];
+} VehicleSlab;
+
+typedef struct {
+  long slabs;       // slabs allocated so far (never returned until freed)
+  long capacity;    // vehicles the slabs can hold
+  long inUse;       // vehicles currently allocated
+  long peakInUse;   // high-water mark of inUse
+  long allocations; // total poolAlloc() calls that succeeded
+} VehiclePoolStats;
+
+// Structure-of-arrays store for Vehicles, addressed by VehicleId: the slab
+// is id >> VEHICLE_SLAB_SHIFT, the index in it the low bits. Slabs are never
+// moved, and a free list over them means the steady state of
+// allocate-on-arrival / free-on-service never hits malloc.
+// Lock-free for one allocating thread (the reader) and any number of freeing
+// threads: frees are pushed on an atomic stack that the allocator takes over
+// in one exchange when its private free list runs dry. An id handed to
+// another thread through a Queue makes its slab visible there too
+typedef struct {
+  VehicleSlab *slabs[VEHICLE_MAX_SLABS];
+  VehicleId freeList; // owned by the allocating thread
+  _Atomic VehicleId returned;
+  _Atomic long slabCount;
+  _Atomic long allocations;
+  _Atomic long frees;
+  _Atomic long peakInUse;
+} VehiclePool;
+
+// One field of vehicle 'id', as an lvalue
+#define VEHICLE_FIELD(pool, id, field)                                         \
+  ((pool)->slabs[(id) >> VEHICLE_SLAB_SHIFT]->field[(id) & VEHICLE_SLAB_MASK])
+
+VehiclePool *createVehiclePool();
+// Single allocating thread only. NO_VEHICLE if out of memory
+VehicleId poolAlloc(VehiclePool *pool);
+void poolFree(VehiclePool *pool, VehicleId id);
+VehiclePoolStats getPoolStats(VehiclePool *pool);
+void printPoolStats(FILE *out, const VehiclePoolStats *s);
+
+// All fields of a vehicle at once, e.g. to move it to another pool
+void loadVehicle(const VehiclePool *pool, VehicleId id, Vehicle *v);
+void storeVehicle(VehiclePool *pool, VehicleId id, const Vehicle *v);
+
+// Releases every slab at once, including vehicles still in use
+void freeVehiclePool(VehiclePool *pool);
+
+#endif
@@ -0,0 +1,500 @@
+#include "vehicle_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <libgen.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "event_sim.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+const char *VEHICLE_FILE = "vehicles.data";
+uint64_t generatorSeed = 0;
+
+// Adds the vehicle to its road's queue, frees it if it cannot be queued. The
+// transport delay is taken first: once queued the vehicle belongs to the
+// controller
+static void addVehicle(Junction *j, VehicleId v) {
+  VehiclePool *pool = j->pool;
+  SimTime transport = VEHICLE_FIELD(pool, v, ingestedAt) -
+                      VEHICLE_FIELD(pool, v, generatedAt);
+  int result = junctionEnqueue(j, v);
+
+  // A served vehicle keeps its fields until this thread allocates its slot
+  // again, so they can still be printed
+  if (result == 0) {
+    recordLatency(&j->transport, transport);
+    if (VEHICLE_FIELD(pool, v, lane) == 0)
+      printf("+ Vehicle %s added to Road %c queue\n",
+             VEHICLE_FIELD(pool, v, vehicleNumber), VEHICLE_FIELD(pool, v, road));
+    else
+      printf("+ Vehicle %s added to %cL%d queue\n",
+             VEHICLE_FIELD(pool, v, vehicleNumber), VEHICLE_FIELD(pool, v, road),
+             VEHICLE_FIELD(pool, v, lane));
+  } else {
+    // Unknown road or out of memory
+    poolFree(j->pool, v);
+  }
+}
+
+// Builds a queued vehicle from a binary transport record
+static VehicleId vehicleFromRecord(Junction *j, const VehicleRecord *rec) {
+  VehiclePool *pool = j->pool;
+  VehicleId v = poolAlloc(pool);
+  if (v == NO_VEHICLE)
+    return NO_VEHICLE;
+
+  char *plate = VEHICLE_FIELD(pool, v, vehicleNumber);
+  memcpy(plate, rec->plate, PLATE_LENGTH);
+  plate[PLATE_LENGTH] = '\0';
+  VEHICLE_FIELD(pool, v, road) = rec->road;
+  VEHICLE_FIELD(pool, v, lane) = rec->lane;
+  VEHICLE_FIELD(pool, v, generatedAt) = rec->timestampNs;
+  VEHICLE_FIELD(pool, v, ingestedAt) = monotonicNs();
+  return v;
+}
+
+// Parses one "VEHICLEID:ROAD[:LANE[:GENERATED_NS]]" line (e.g. "AA1BB234:A",
+// "AA1BB234:A:3" or "AA1BB234:A:0:81234567890123") and queues the vehicle.
+// Without a lane number (or with 0) the vehicle joins the road's first lane;
+// without a generation timestamp it counts as generated when read
+static void parseVehicleLine(char *line, Junction *j) {
+  SimTime ingestedAt = monotonicNs();
+  char *vehicleNumber = strtok(line, ":");
+  char *roadStr = strtok(NULL, ":");
+  char *laneStr = strtok(NULL, ":");
+  char *stampStr = strtok(NULL, ":");
+
+  if (!vehicleNumber || !roadStr)
+    return;
+
+  // A bad lane or timestamp rejects the line rather than queueing the
+  // vehicle on a wrong lane or with a made-up generation time
+  long lane = 0;
+  SimTime generatedAt = ingestedAt;
+  char *end;
+  if (laneStr) {
+    errno = 0;
+    lane = strtol(laneStr, &end, 10);
+    if (errno || end == laneStr || *end != '\0' || lane < 0 ||
+        lane > UCHAR_MAX) {
+      printf("Warning: Bad lane '%s' for vehicle %s, line ignored\n", laneStr,
+             vehicleNumber);
+      j->malformed++;
+      return;
+    }
+  }
+  if (stampStr) {
+    errno = 0;
+    generatedAt = strtoll(stampStr, &end, 10);
+    if (errno || end == stampStr || *end != '\0' || generatedAt < 0) {
+      printf("Warning: Bad timestamp '%s' for vehicle %s, line ignored\n",
+             stampStr, vehicleNumber);
+      j->malformed++;
+      return;
+    }
+  }
+
+  // Create new vehicle
+  VehiclePool *pool = j->pool;
+  VehicleId v = poolAlloc(pool);
+  if (v == NO_VEHICLE)
+    return;
+
+  char *plate = VEHICLE_FIELD(pool, v, vehicleNumber);
+  strncpy(plate, vehicleNumber, 9);
+  plate[9] = '\0';
+  VEHICLE_FIELD(pool, v, road) = roadStr[0];
+  VEHICLE_FIELD(pool, v, lane) = (unsigned char)lane;
+  VEHICLE_FIELD(pool, v, ingestedAt) = ingestedAt;
+  VEHICLE_FIELD(pool, v, generatedAt) = generatedAt;
+
+  addVehicle(j, v);
+}
+
+// (Re)opens the tailed file. A freshly created file is read from the start,
+// the file present at startup from its end so old history is ignored
+static void openTailedFile(FileTailer *t, bool fromEnd) {
+  struct stat st;
+
+  t->fd = open(t->path, O_RDONLY | O_CLOEXEC);
+  t->offset = 0;
+  t->size = 0;
+  t->consumedLen = 0;
+  t->partialLen = 0;
+  if (t->fd < 0)
+    return;
+
+  if (fstat(t->fd, &st) == 0) {
+    t->inode = st.st_ino;
+    if (fromEnd) {
+      t->offset = st.st_size;
+      t->size = st.st_size;
+    }
+  }
+}
+
+// Keeps the last TAILER_CHECK_BYTES consumed
+static void rememberConsumed(FileTailer *t, const char *data, size_t n) {
+  if (n >= TAILER_CHECK_BYTES) {
+    memcpy(t->consumed, data + n - TAILER_CHECK_BYTES, TAILER_CHECK_BYTES);
+    t->consumedLen = TAILER_CHECK_BYTES;
+    return;
+  }
+  size_t keep = t->consumedLen + n > TAILER_CHECK_BYTES
+                    ? TAILER_CHECK_BYTES - n
+                    : t->consumedLen;
+  memmove(t->consumed, t->consumed + t->consumedLen - keep, keep);
+  memcpy(t->consumed + keep, data, n);
+  t->consumedLen = keep + n;
+}
+
+// True if the file was truncated since the last drain: it shrank, or the
+// bytes just before the offset are not the ones consumed there
+static bool wasTruncated(FileTailer *t, off_t size) {
+  if (size < t->size || size < t->offset)
+    return true;
+  if (t->consumedLen == 0)
+    return false;
+
+  char check[TAILER_CHECK_BYTES];
+  ssize_t n = pread(t->fd, check, t->consumedLen,
+                    t->offset - (off_t)t->consumedLen);
+  return n != (ssize_t)t->consumedLen ||
+         memcmp(check, t->consumed, t->consumedLen) != 0;
+}
+
+static void closeTailedFile(FileTailer *t) {
+  if (t->fd >= 0)
+    close(t->fd);
+  t->fd = -1;
+  t->partialLen = 0;
+}
+
+// Reads everything appended since the last call and parses complete lines.
+// An unterminated last line is kept until the rest of it arrives
+static void readAppended(FileTailer *t, Junction *j) {
+  char buffer[4096];
+  ssize_t n;
+
+  while ((n = pread(t->fd, buffer, sizeof(buffer), t->offset)) > 0) {
+    t->offset += n;
+    rememberConsumed(t, buffer, (size_t)n);
+
+    for (ssize_t i = 0; i < n; i++) {
+      if (buffer[i] != '\n') {
+        // Overlong lines are dropped instead of split into bogus records
+        if (t->partialLen < sizeof(t->partial) - 1)
+          t->partial[t->partialLen++] = buffer[i];
+        continue;
+      }
+
+      t->partial[t->partialLen] = '\0';
+      if (t->partialLen > 0 && t->partialLen < sizeof(t->partial) - 1)
+        parseVehicleLine(t->partial, j);
+      t->partialLen = 0;
+    }
+  }
+
+  if (n < 0 && errno != EINTR)
+    perror("Error reading vehicle file");
+}
+
+// Catches up with the file, following truncation and rotation
+void drainTailedFile(FileTailer *t, Junction *j) {
+  struct stat pathStat, fdStat;
+
+  if (t->fd < 0) {
+    openTailedFile(t, false);
+    if (t->fd < 0)
+      return;
+  }
+
+  // Rotated: finish the old file, then switch to the new one at the same path
+  if (stat(t->path, &pathStat) == 0 && pathStat.st_ino != t->inode) {
+    readAppended(t, j);
+    closeTailedFile(t);
+    openTailedFile(t, false);
+    if (t->fd < 0)
+      return;
+  }
+
+  // Truncated (the generator reopens with "w" on startup): start over
+  bool sized = fstat(t->fd, &fdStat) == 0;
+  if (sized && wasTruncated(t, fdStat.st_size)) {
+    printf("Vehicle file truncated, reading from the start\n");
+    t->offset = 0;
+    t->consumedLen = 0;
+    t->partialLen = 0;
+  }
+
+  readAppended(t, j);
+  if (sized && fdStat.st_size > t->offset)
+    t->size = fdStat.st_size;
+  else
+    t->size = t->offset;
+}
+
+int initFileTailer(FileTailer *t, const char *path) {
+  memset(t, 0, sizeof(*t));
+  t->path = path;
+  t->fd = -1;
+  t->watchFd = -1;
+
+  // Start reading from the END of the file to ignore old history
+  // This ensures queues start empty (0) and only new vehicles appear
+  openTailedFile(t, true);
+
+#ifdef __linux__
+  // Watch the directory rather than the file so creation and rename of
+  // vehicles.data are seen as well as appends
+  char dirBuffer[4096];
+  snprintf(dirBuffer, sizeof(dirBuffer), "%s", path);
+  const char *dir = dirname(dirBuffer);
+
+  t->watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (t->watchFd < 0) {
+    perror("Warning: inotify unavailable, falling back to polling");
+  } else if (inotify_add_watch(t->watchFd, dir,
+                               IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE |
+                                   IN_MOVED_TO | IN_DELETE) < 0) {
+    perror("Warning: Failed to watch vehicle file directory");
+    close(t->watchFd);
+    t->watchFd = -1;
+  }
+#endif
+
+  return 0;
+}
+
+void closeFileTailer(FileTailer *t) {
+  closeTailedFile(t);
+  if (t->watchFd >= 0)
+    close(t->watchFd);
+  t->watchFd = -1;
+}
+
+// Blocks until the file may have changed or timeoutMs elapses. Returns true if
+// the file should be drained
+bool waitForFileChange(FileTailer *t, int timeoutMs) {
+#ifdef __linux__
+  if (t->watchFd >= 0) {
+    struct pollfd pfd = {t->watchFd, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0)
+      return false;
+
+    // Only react to events for our own file, other files share the directory
+    char events[4096]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+    char nameBuffer[4096];
+    snprintf(nameBuffer, sizeof(nameBuffer), "%s", t->path);
+    const char *name = basename(nameBuffer);
+    bool relevant = false;
+    ssize_t len;
+
+    while ((len = read(t->watchFd, events, sizeof(events))) > 0) {
+      for (char *p = events; p < events + len;) {
+        struct inotify_event *ev = (struct inotify_event *)p;
+        if (ev->len > 0 && strcmp(ev->name, name) == 0)
+          relevant = true;
+        p += sizeof(struct inotify_event) + ev->len;
+      }
+    }
+    return relevant;
+  }
+#endif
+
+  // Without inotify, poll the file at a short interval
+  sleepNs((SimTime)timeoutMs * 1000000 / 2);
+  return true;
+}
+
+// Tails vehicles.data and feeds new vehicles into the junction queues
+void *readAndParseFile(void *arg) {
+  SharedData *sharedData = (SharedData *)arg;
+  Junction *j = sharedData->junction;
+  FileTailer tailer;
+
+  printf("File reading thread started\n");
+  printf("Monitoring file: %s\n", VEHICLE_FILE);
+
+  initFileTailer(&tailer, VEHICLE_FILE);
+
+  while (!sharedData->stopSimulation) {
+    // The timeout only bounds how long a stop request can go unnoticed
+    if (waitForFileChange(&tailer, READER_WAKEUP_MS))
+      drainTailedFile(&tailer, j);
+  }
+
+  closeFileTailer(&tailer);
+  return NULL;
+}
+
+// Consumes the shared-memory ring filled by traffic_generator --transport shm
+// Swaps a ring its producer closed for the one now under the same name,
+// creating it if the next generator hasn't started yet. Until the old name
+// is removed the same closed segment is found again, so that is retried
+static void reopenVehicleRing(VehicleRing *ring, SharedData *sharedData) {
+  printf("Shared memory ring closed by the generator, reopening\n");
+  closeVehicleRing(ring);
+  while (!sharedData->stopSimulation) {
+    if (openVehicleRing(ring, VEHICLE_RING_NAME) == 0) {
+      if (!vehicleRingClosed(ring))
+        return;
+      closeVehicleRing(ring);
+    }
+    sleepNs((SimTime)READER_WAKEUP_MS * 1000000);
+  }
+}
+
+void *readVehicleRing(void *arg) {
+  SharedData *sharedData = (SharedData *)arg;
+  Junction *j = sharedData->junction;
+  VehicleRing ring;
+  VehicleRecord rec;
+
+  printf("Shared memory reading thread started\n");
+  printf("Monitoring ring: %s\n", VEHICLE_RING_NAME);
+
+  if (openVehicleRing(&ring, VEHICLE_RING_NAME) < 0)
+    return NULL;
+
+  // Skip records left over from an earlier run, like the file reader does
+  atomic_store(&ring.shared->tail, atomic_load(&ring.shared->head));
+
+  while (!sharedData->stopSimulation) {
+    if (!ringPop(&ring, &rec)) {
+      // Drained and the generator has gone: follow it to its next segment
+      if (vehicleRingClosed(&ring))
+        reopenVehicleRing(&ring, sharedData);
+      else
+        sleepNs(RING_IDLE_SLEEP_NS);
+      continue;
+    }
+
+    VehicleId v = vehicleFromRecord(j, &rec);
+    if (v != NO_VEHICLE)
+      addVehicle(j, v);
+  }
+
+  closeVehicleRing(&ring);
+  return NULL;
+}
+
+// Follows the binary log written by traffic_generator --format binary. The
+// file is memory-mapped and records are read in place
+void *readVehicleLogFile(void *arg) {
+  SharedData *sharedData = (SharedData *)arg;
+  Junction *j = sharedData->junction;
+  FileTailer watcher; // only used for its change notifications
+  VehicleLog log;
+  struct stat pathStat, fdStat;
+  size_t next = 0;
+
+  printf("Binary log reading thread started\n");
+  printf("Monitoring file: %s\n", VEHICLE_LOG_FILE);
+
+  initFileTailer(&watcher, VEHICLE_LOG_FILE);
+
+  // Like the text reader, ignore records already in the log at startup
+  bool mapped = mapVehicleLog(&log, VEHICLE_LOG_FILE) == 0;
+  if (mapped)
+    next = log.count;
+
+  while (!sharedData->stopSimulation) {
+    if (!waitForFileChange(&watcher, READER_WAKEUP_MS))
+      continue;
+
+    // Replaced by a new file: start over on the new one
+    if (mapped && stat(VEHICLE_LOG_FILE, &pathStat) == 0 &&
+        fstat(log.fd, &fdStat) == 0 && pathStat.st_ino != fdStat.st_ino) {
+      unmapVehicleLog(&log);
+      mapped = false;
+    }
+
+    if (!mapped) {
+      if (mapVehicleLog(&log, VEHICLE_LOG_FILE) != 0)
+        continue;
+      mapped = true;
+      next = 0;
+    } else if (refreshVehicleLog(&log) == 0) {
+      next = 0;
+    }
+
+    for (; next < log.count; next++) {
+      VehicleId v = vehicleFromRecord(j, &log.records[next]);
+      if (v != NO_VEHICLE)
+        addVehicle(j, v);
+    }
+  }
+
+  if (mapped)
+    unmapVehicleLog(&log);
+  closeFileTailer(&watcher);
+  return NULL;
+}
+
+// Feeds the junction from the lanes' arrival models without a separate
+// traffic_generator process. Sleeps until the earliest pending arrival
+void *generateVehicles(void *arg) {
+  SharedData *sharedData = (SharedData *)arg;
+  Junction *j = sharedData->junction;
+  int laneCount = j->config.laneCount;
+  Rng rng;
+
+  printf("Arrival generator thread started (seed %llu)\n",
+         (unsigned long long)generatorSeed);
+
+  ArrivalStream *streams =
+      (ArrivalStream *)malloc(sizeof(ArrivalStream) * laneCount);
+  if (!streams) {
+    printf("Error: Failed to allocate memory for arrival streams\n");
+    return NULL;
+  }
+  rngSeed(&rng, generatorSeed, 0);
+  for (int i = 0; i < laneCount; i++)
+    initArrivalStream(&streams[i], &j->config.lanes[i].arrivals, &rng, 0);
+
+  SimTime start = monotonicNs();
+  while (!sharedData->stopSimulation) {
+    int lane = 0;
+    for (int i = 1; i < laneCount; i++) {
+      if (streams[i].next < streams[lane].next)
+        lane = i;
+    }
+
+    // The wake-up bound only limits how long a stop request can go unnoticed
+    SimTime wait = start + streams[lane].next - monotonicNs();
+    if (streams[lane].next == INT64_MAX || wait > 0) {
+      SimTime bound = (SimTime)READER_WAKEUP_MS * 1000000;
+      sleepNs(streams[lane].next == INT64_MAX || wait > bound ? bound : wait);
+      continue;
+    }
+
+    // Generated when due, so the transport delay is the wake-up lag
+    SimTime due = start + nextArrival(&streams[lane]);
+    VehicleId v = poolAlloc(j->pool);
+    if (v == NO_VEHICLE)
+      continue;
+    generateVehicleNumber(VEHICLE_FIELD(j->pool, v, vehicleNumber), &rng);
+    VEHICLE_FIELD(j->pool, v, road) = j->config.lanes[lane].road;
+    VEHICLE_FIELD(j->pool, v, lane) =
+        (unsigned char)j->config.lanes[lane].laneNumber;
+    VEHICLE_FIELD(j->pool, v, generatedAt) = due;
+    VEHICLE_FIELD(j->pool, v, ingestedAt) = monotonicNs();
+    addVehicle(j, v);
+  }
+
+  free(streams);
+  return NULL;
+}
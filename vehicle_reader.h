@@ -0,0 +1,49 @@
+#ifndef VEHICLE_READER_H
+#define VEHICLE_READER_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "arrivals.h"
+#include "signal_control.h"
+#include "vehicle_log.h"
+#include "vehicle_ring.h"
+
+#define MAX_LINE_LENGTH 48 // "AA1BB234:A:3:" plus a 64-bit ns timestamp
+#define TAILER_CHECK_BYTES 32 // bytes before the offset checked on each drain
+#define READER_WAKEUP_MS 200 // max delay before a stop request is noticed
+#define RING_IDLE_SLEEP_NS 1000000LL // 1 ms back-off when the ring is empty
+
+extern const char *VEHICLE_FILE;
+extern uint64_t generatorSeed; // seed of generateVehicles(), set before start
+
+// Incremental reader for an append-only text file. The descriptor stays open
+// between reads; on Linux, inotify wakes the reader as soon as data arrives
+typedef struct {
+  const char *path;
+  int fd;       // -1 while the file does not exist
+  int watchFd;  // inotify instance, -1 when polling
+  ino_t inode;  // identity of the open file, to detect rotation
+  off_t offset; // bytes consumed so far
+  off_t size;   // file size seen by the last drain
+  // Last bytes consumed. If the file no longer has them at the same place
+  // it was truncated and rewritten, even past the old size
+  char consumed[TAILER_CHECK_BYTES];
+  size_t consumedLen;
+  char partial[MAX_LINE_LENGTH];
+  size_t partialLen;
+} FileTailer;
+
+int initFileTailer(FileTailer *t, const char *path);
+bool waitForFileChange(FileTailer *t, int timeoutMs);
+void drainTailedFile(FileTailer *t, Junction *j);
+void closeFileTailer(FileTailer *t);
+
+// Reader threads, arg is a SharedData*
+void *readAndParseFile(void *arg);
+void *readVehicleRing(void *arg);
+void *readVehicleLogFile(void *arg);
+// Generates arrivals in process from each lane's arrival model, in real time
+void *generateVehicles(void *arg);
+
+#endif
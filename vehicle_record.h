@@ -0,0 +1,20 @@
+#ifndef VEHICLE_RECORD_H
+#define VEHICLE_RECORD_H
+
+#include <stdint.h>
+
+#define PLATE_LENGTH 8
+
+// Fixed-size vehicle record shared by the binary transports. The plate is not
+// NUL-terminated (generator plates are exactly 8 characters)
+typedef struct {
+  char plate[PLATE_LENGTH];
+  char road;           // 'A'..'D'
+  uint8_t lane;        // lane number on the road (0 if unknown)
+  uint8_t reserved[6]; // keeps timestampNs 8-byte aligned
+  int64_t timestampNs; // CLOCK_MONOTONIC time the vehicle was generated
+} VehicleRecord;
+
+_Static_assert(sizeof(VehicleRecord) == 24, "VehicleRecord must stay 24 bytes");
+
+#endif
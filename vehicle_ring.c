@@ -0,0 +1,130 @@
+#include "vehicle_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sim_time.h"
+
+int openVehicleRing(VehicleRing *r, const char *name) {
+  size_t mapSize =
+      sizeof(VehicleRingShared) + sizeof(VehicleRecord) * VEHICLE_RING_CAPACITY;
+
+  // Exactly one process creates the segment and initializes its header
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  bool created = fd >= 0;
+  if (!created && errno == EEXIST)
+    fd = shm_open(name, O_RDWR, 0600);
+  if (fd < 0) {
+    perror("Error opening shared memory ring");
+    return -1;
+  }
+
+  // New segments are zero-filled, which is already an empty ring. An
+  // existing one may not be sized yet if its creator is just starting
+  SimTime deadline = monotonicNs() + VEHICLE_RING_OPEN_TIMEOUT_NS;
+  struct stat st;
+  if (created && ftruncate(fd, (off_t)mapSize) < 0) {
+    perror("Error sizing shared memory ring");
+    close(fd);
+    return -1;
+  }
+  while (!created && fstat(fd, &st) == 0 && (size_t)st.st_size < mapSize &&
+         monotonicNs() < deadline)
+    sleepNs(1000000);
+  if (!created && (fstat(fd, &st) < 0 || (size_t)st.st_size < mapSize)) {
+    printf("Error: Shared ring %s was never sized by its creator\n", name);
+    close(fd);
+    return -1;
+  }
+
+  void *mem = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    perror("Error mapping shared memory ring");
+    return -1;
+  }
+
+  r->shared = (VehicleRingShared *)mem;
+  r->mapSize = mapSize;
+  r->mask = VEHICLE_RING_CAPACITY - 1;
+
+  VehicleRingShared *s = r->shared;
+  if (created) {
+    s->capacity = VEHICLE_RING_CAPACITY;
+    // Publishes the header: whoever sees the magic also sees the capacity
+    atomic_store_explicit(&s->magic, VEHICLE_RING_MAGIC, memory_order_release);
+    return 0;
+  }
+
+  while (atomic_load_explicit(&s->magic, memory_order_acquire) !=
+             VEHICLE_RING_MAGIC &&
+         monotonicNs() < deadline)
+    sleepNs(1000000);
+  if (atomic_load_explicit(&s->magic, memory_order_acquire) !=
+      VEHICLE_RING_MAGIC) {
+    printf("Error: Shared ring %s was never initialized, remove "
+           "/dev/shm%s\n",
+           name, name);
+    closeVehicleRing(r);
+    return -1;
+  }
+  if (s->capacity != VEHICLE_RING_CAPACITY) {
+    printf("Error: Shared ring %s has capacity %u, expected %d\n", name,
+           s->capacity, VEHICLE_RING_CAPACITY);
+    closeVehicleRing(r);
+    return -1;
+  }
+
+  return 0;
+}
+
+void closeVehicleRing(VehicleRing *r) {
+  if (r->shared)
+    munmap(r->shared, r->mapSize);
+  r->shared = NULL;
+}
+
+void markVehicleRingClosed(VehicleRing *r) {
+  atomic_store_explicit(&r->shared->closed, 1, memory_order_release);
+}
+
+bool vehicleRingClosed(const VehicleRing *r) {
+  return atomic_load_explicit(&r->shared->closed, memory_order_acquire) != 0;
+}
+
+void unlinkVehicleRing(const char *name) {
+  if (shm_unlink(name) < 0 && errno != ENOENT)
+    perror("Error removing shared memory ring");
+}
+
+bool ringPush(VehicleRing *r, const VehicleRecord *rec) {
+  VehicleRingShared *s = r->shared;
+  uint64_t head = atomic_load_explicit(&s->head, memory_order_relaxed);
+  uint64_t tail = atomic_load_explicit(&s->tail, memory_order_acquire);
+
+  if (head - tail >= VEHICLE_RING_CAPACITY)
+    return false;
+
+  s->records[head & r->mask] = *rec;
+  // Publish the record before the consumer can see the new head
+  atomic_store_explicit(&s->head, head + 1, memory_order_release);
+  return true;
+}
+
+bool ringPop(VehicleRing *r, VehicleRecord *out) {
+  VehicleRingShared *s = r->shared;
+  uint64_t tail = atomic_load_explicit(&s->tail, memory_order_relaxed);
+  uint64_t head = atomic_load_explicit(&s->head, memory_order_acquire);
+
+  if (tail == head)
+    return false;
+
+  *out = s->records[tail & r->mask];
+  // Hand the slot back to the producer only after it has been copied
+  atomic_store_explicit(&s->tail, tail + 1, memory_order_release);
+  return true;
+}
@@ -0,0 +1,62 @@
+#ifndef VEHICLE_RING_H
+#define VEHICLE_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vehicle_record.h"
+
+#define VEHICLE_RING_NAME "/dsa_vehicle_ring"
+#define VEHICLE_RING_CAPACITY 4096 // records, must be a power of two
+#define VEHICLE_RING_MAGIC 0x56524E47u // "VRNG"
+#define VEHICLE_RING_OPEN_TIMEOUT_NS 1000000000LL // wait for the creator
+
+// Layout of the POSIX shared-memory segment. head is only written by the
+// producer and tail only by the consumer, each on its own cache line. The
+// process that created the segment fills in the header and publishes it by
+// storing magic last. 'closed' is set by the producer before it removes the
+// segment's name, telling the consumer to attach to the next segment
+typedef struct {
+  _Atomic uint32_t magic;
+  uint32_t capacity;
+  _Atomic uint32_t closed;
+  char pad0[52];
+  _Atomic uint64_t head; // next slot the producer writes
+  char pad1[56];
+  _Atomic uint64_t tail; // next slot the consumer reads
+  char pad2[56];
+  VehicleRecord records[];
+} VehicleRingShared;
+
+typedef struct {
+  VehicleRingShared *shared;
+  size_t mapSize;
+  uint64_t mask;
+} VehicleRing;
+
+// Opens the ring, creating it if needed, so either process can start first.
+// Returns 0 on success, -1 on error
+int openVehicleRing(VehicleRing *r, const char *name);
+void closeVehicleRing(VehicleRing *r);
+
+// Removes the segment's name. Processes that still have it mapped keep
+// using it; the next open creates a fresh, empty ring
+void unlinkVehicleRing(const char *name);
+
+// Producer side: no more records will come through this segment. Call
+// before unlinking it
+void markVehicleRingClosed(VehicleRing *r);
+
+// Consumer side: true once the producer closed the segment. Records pushed
+// before that are still there to pop
+bool vehicleRingClosed(const VehicleRing *r);
+
+// Producer side, returns false if the ring is full
+bool ringPush(VehicleRing *r, const VehicleRecord *rec);
+
+// Consumer side, returns false if the ring is empty
+bool ringPop(VehicleRing *r, VehicleRecord *out);
+
+#endif